@@ -7,215 +7,568 @@
  */
 
 #include "config.h"
+#include "twi.h"
 #include "sensor.h"
+#if ADAPTIVE_SAMPLING_ENABLED
+  #include "sampling.h"
+#endif
+#if SENSOR_DHT22_ENABLED || DHT2_PIN
+  #include "dht22.h"
+#endif
+#if SENSOR_SHT31_ENABLED
+  #include "sht3x.h"
+#endif
+#if SENSOR_BME280_ENABLED
+  #include "bme280.h"
+#endif
 #include "display.h"
 #include "encoder.h"
 #include "humidifier.h"
 #include "menu.h"
 #include "storage.h"
 #include "analytics.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "power.h"
+#include "log.h"
+#include "history.h"
+#include "memory.h"
+#if DISPLAY_BENCH_ENABLED
+  #include "bench.h"
+#endif
 
+// Шина I2C: кадры дисплея и обмен с датчиками на I2C
+TwiQueue i2cBus;
+// Датчики в порядке опроса
+#if SENSOR_DHT22_ENABLED
+Dht22 dhtSensor(DHT_PIN);
+#endif
+#if DHT2_PIN
+Dht22 dht2Sensor(DHT2_PIN);
+#endif
+#if SENSOR_SHT31_ENABLED
+Sht3x shtSensor;
+#endif
+#if SENSOR_BME280_ENABLED
+Bme280 bmeSensor;
+#endif
 Sensor sensor;
+#if ADAPTIVE_SAMPLING_ENABLED
+SampleRate sampleRate;
+#endif
+
+// Имена датчиков для экрана, не длиннее 7 символов
+#define SENSOR_PIN_NAME(pin) SENSOR_PIN_NAME_(pin)
+#define SENSOR_PIN_NAME_(pin) "DHT D" #pin
+#if SENSOR_DHT22_ENABLED
+static const char sensorNameDht[] PROGMEM = SENSOR_PIN_NAME(DHT_PIN);
+#endif
+#if DHT2_PIN
+static const char sensorNameDht2[] PROGMEM = SENSOR_PIN_NAME(DHT2_PIN);
+#endif
+#if SENSOR_SHT31_ENABLED
+static const char sensorNameSht[] PROGMEM = "SHT31";
+#endif
+#if SENSOR_BME280_ENABLED
+static const char sensorNameBme[] PROGMEM = "BME280";
+#endif
+#define FLASH_NAME(name) reinterpret_cast<const __FlashStringHelper*>(name)
 Display display;
 EncoderModule encoder;
 Humidifier humidifier;
 Menu menu;
 Storage storage;
 Analytics analytics;
+#if HISTORY_ENABLED
+History history;
+#endif
+
+Scheduler scheduler;
+#if PROFILER_ENABLED
+Profiler profiler;
+#endif
+Power power;
+#if LOG_LEVEL > LOG_LEVEL_NONE
+Logger logger;
+#endif
+#if DISPLAY_BENCH_ENABLED
+DisplayBench displayBench;
+#endif
+#if MEMORY_MONITOR_ENABLED
+MemoryMonitor memory;
+
+// Объекты модулей в SRAM: имя (не длиннее 5 символов для экрана) и размер
+static const char memNameSensor[] PROGMEM = "Sens";
+static const char memNameSampling[] PROGMEM = "Smpl";
+static const char memNameDrivers[] PROGMEM = "Drv";
+static const char memNameDisplay[] PROGMEM = "Disp";
+static const char memNameBus[] PROGMEM = "I2C";
+static const char memNameEncoder[] PROGMEM = "Enc";
+static const char memNameHumidifier[] PROGMEM = "Humid";
+static const char memNameMenu[] PROGMEM = "Menu";
+static const char memNameStorage[] PROGMEM = "Stor";
+static const char memNameAnalytics[] PROGMEM = "Analy";
+static const char memNameHistory[] PROGMEM = "Hist";
+static const char memNameScheduler[] PROGMEM = "Sched";
+static const char memNameProfiler[] PROGMEM = "Prof";
+static const char memNamePower[] PROGMEM = "Power";
+static const char memNameLogger[] PROGMEM = "Log";
+static const char memNameBench[] PROGMEM = "Bench";
+static const char memNameMemory[] PROGMEM = "Mem";
+static const char memNameSerial[] PROGMEM = "UART";
+
+static const MemoryModule memoryModules[] PROGMEM = {
+  { memNameSensor, sizeof(sensor) },
+#if ADAPTIVE_SAMPLING_ENABLED
+  { memNameSampling, sizeof(sampleRate) },
+#endif
+  { memNameDrivers, 0
+#if SENSOR_DHT22_ENABLED
+    + sizeof(dhtSensor)
+#endif
+#if DHT2_PIN
+    + sizeof(dht2Sensor)
+#endif
+#if SENSOR_SHT31_ENABLED
+    + sizeof(shtSensor)
+#endif
+#if SENSOR_BME280_ENABLED
+    + sizeof(bmeSensor)
+#endif
+  },
+  { memNameDisplay, sizeof(display) },
+  { memNameBus, sizeof(i2cBus) },
+  { memNameEncoder, sizeof(encoder) },
+  { memNameHumidifier, sizeof(humidifier) },
+  { memNameMenu, sizeof(menu) },
+  { memNameStorage, sizeof(storage) },
+  { memNameAnalytics, sizeof(analytics) },
+#if HISTORY_ENABLED
+  { memNameHistory, sizeof(history) },
+#endif
+  { memNameScheduler, sizeof(scheduler) },
+#if PROFILER_ENABLED
+  { memNameProfiler, sizeof(profiler) },
+#endif
+  { memNamePower, sizeof(power) },
+#if LOG_LEVEL > LOG_LEVEL_NONE
+  { memNameLogger, sizeof(logger) },
+#endif
+#if DISPLAY_BENCH_ENABLED
+  { memNameBench, sizeof(displayBench) },
+#endif
+  { memNameMemory, sizeof(memory) },
+  { memNameSerial, sizeof(Serial) }   // Вместе с буферами приема и передачи
+};
+#endif
 
-unsigned long lastUpdateTime = 0;
-unsigned long lastSaveTime = 0;
-unsigned long lastEncoderActivity = 0;
-unsigned long lastDisplayUpdate = 0;
 bool displayNeedsUpdate = false;
+int8_t sensorTaskId = -1;
+// Конец прошлого круга замеров: период между кругами переменный
+unsigned long lastMeasureTime = 0;
+unsigned long workTimeMs = 0;   // Работа увлажнителя, еще не учтенная в storage
+int8_t inputTaskId = -1;
+int8_t displayTaskId = -1;
+
+// ============================================================================
+// ЗАДАЧИ ПЛАНИРОВЩИКА
+// ============================================================================
+
+// Энкодер, яркость, меню и переключение экранов
+void taskInput() {
+  // Яркость: любое событие энкодера будит дисплей
+  if (encoder.hasEvent()) {
+    display.setBrightness(BRIGHTNESS_FULL);
+  }
+
+  // Меню само разбирает очередь событий
+  if (menu.isActive()) {
+    menu.tick();
+    if (menu.isRedrawPending()) {
+      PROFILE_SCOPE(PROF_DRAW_MENU);
+      menu.draw();
+    }
+    // Кадр меню ждет, пока прошлый уйдет на шину
+    if (menu.isRedrawPending()) scheduler.runIn(inputTaskId, DISPLAY_BUSY_RETRY);
+    // Меню закрылось - главный экран под ним испорчен
+    if (!menu.isActive()) {
+      display.invalidate();
+      displayNeedsUpdate = true;
+    }
+  } else {
+    uint8_t event;
+    while (!menu.isActive() && (event = encoder.popEvent()) != ENC_EVENT_NONE) {
+      switch (event & ENC_EVENT_MASK) {
+        // Двойной клик - вход в меню
+        case ENC_EVENT_DOUBLE:
+          LOG_D("ENC", "double click");
+          menu.open();
+          break;
+
+        // Главный экран - переключение экранов только при вращении вправо
+        case ENC_EVENT_RIGHT:
+          LOG_D("ENC", "right");
+          if (display.getMode() == MODE_GRAPH) {
+            display.toggleGraphScreen();
+          } else {
+            display.toggleMode();
+          }
+          displayNeedsUpdate = true;
+          break;
+
+        // Вращение влево на живом графике - выбор кривых
+        case ENC_EVENT_LEFT:
+          LOG_D("ENC", "left");
+          if (display.getMode() == MODE_GRAPH &&
+              display.getGraphScreen() == GRAPH_SCREEN_GRAPH) {
+            display.toggleGraphSeries();
+            displayNeedsUpdate = true;
+          }
+          break;
+      }
+    }
+  }
+
+  unsigned long inactiveTime = millis() - encoder.getLastActivity();
+  if (inactiveTime >= DIM_TIMEOUT_2) display.setBrightness(BRIGHTNESS_DIM2);
+  else if (inactiveTime >= DIM_TIMEOUT_1) display.setBrightness(BRIGHTNESS_DIM1);
+}
+
+// Опрос датчика. Пока идет измерение - каждую мс, иначе задача спит
+// до следующего измерения. По готовности - управление увлажнителем
+// и новый период замера (sampling.h). Учет времени работы, истории и
+// статистики - по фактическому времени между кругами
+void taskSensor() {
+  bool measured;
+  {
+    PROFILE_SCOPE(PROF_SENSOR);
+    measured = sensor.update();
+  }
+  scheduler.runIn(sensorTaskId, sensor.getPollDelay());
+  if (!measured) return;
+
+  unsigned long now = millis();
+  unsigned long elapsed = now - lastMeasureTime;
+  lastMeasureTime = now;
+
+  bool sensorOK = sensor.isOK();
+
+  Deci temp = sensor.getTemperature();
+  Deci hum = sensor.getHumidity();
+  Deci filteredHum = sensor.getFilteredHumidity();
+  LOG_D("SENS", "ok=%d T=%d H=%d F=%d (x10)", sensorOK, temp, hum, filteredHum);
+
+  bool running = humidifier.isRunning();
+
+  bool waterOK = true;
+  bool windowOpen = false;
+
+  #if WATER_SENSOR_ENABLED
+    waterOK = !analytics.isWaterLow();
+  #endif
+
+  #if WINDOW_DETECTOR_ENABLED
+    windowOpen = analytics.isWindowOpen();
+  #endif
+
+  display.addGraphPoint(hum, running, temp);
+
+  #if HISTORY_ENABLED
+    if (sensorOK) history.addSample(hum, running, (elapsed + 500) / 1000);
+    else history.tick();
+  #endif
+
+  #if STATS_ENABLED
+    analytics.addSample(temp, hum, running, elapsed);
+  #endif
+
+  if (waterOK && !windowOpen) {
+    // Управление - по отфильтрованной влажности, экран - по замеру
+    humidifier.control(filteredHum, storage.getMinHumidity(), storage.getMaxHumidity(), sensorOK);
+  } else {
+    humidifier.stop();
+  }
+
+  // Время с прошлого круга - в том состоянии, что было до управления
+  if (running) {
+    workTimeMs += elapsed;
+    storage.incrementWorkTime(workTimeMs / 1000);
+    workTimeMs %= 1000;
+  }
+
+  #if ADAPTIVE_SAMPLING_ENABLED
+    sensor.setReadInterval(sampleRate.update(filteredHum, storage.getMinHumidity(),
+                                             storage.getMaxHumidity(), sensorOK));
+    scheduler.runIn(sensorTaskId, sensor.getPollDelay());
+  #endif
+
+  // Данные обновились - нужно перерисовать экран
+  displayNeedsUpdate = true;
+}
+
+#if WATER_SENSOR_ENABLED
+void taskWater() {
+  PROFILE_SCOPE(PROF_WATER);
+  analytics.checkWaterLevel();
+}
+#endif
+
+#if WINDOW_DETECTOR_ENABLED
+void taskWindow() {
+  analytics.updateWindowDetector(sensor.getTemperature());
+}
+#endif
+
+// Перерисовка главного экрана (не чаще DISPLAY_UPDATE_INTERVAL)
+void taskDisplay() {
+  if (menu.isActive() || !displayNeedsUpdate) return;
+  // Прошлый кадр еще уходит на шину - попробуем чуть позже
+  if (display.isBusy()) {
+    scheduler.runIn(displayTaskId, DISPLAY_BUSY_RETRY);
+    return;
+  }
+
+  #if WATER_SENSOR_ENABLED
+    bool waterLow = analytics.isWaterLow();
+    bool waterSensorPresent = analytics.isWaterSensorPresent();
+    uint8_t waterPercent = analytics.getWaterPercent();
+    int waterRawValue = analytics.getWaterRawValue();
+  #else
+    bool waterLow = false;
+    bool waterSensorPresent = false;
+    uint8_t waterPercent = 0;
+    int waterRawValue = 0;
+  #endif
+
+  #if WINDOW_DETECTOR_ENABLED
+    bool windowOpen = analytics.isWindowOpen();
+  #else
+    bool windowOpen = false;
+  #endif
+
+  PROFILE_SCOPE(PROF_DRAW_MAIN);
+  display.drawMainScreen(
+    sensor.getTemperature(),
+    sensor.getHumidity(),
+    storage.getMaxHumidity(),
+    humidifier.isRunning(),
+    storage.getWorkTime(),
+    sensor.isOK(),
+    waterLow,
+    windowOpen,
+    waterSensorPresent,
+    waterPercent,
+    waterRawValue
+  );
+  // Часть полей не влезла в очередь - остаток следующим проходом
+  displayNeedsUpdate = display.hasPendingFields();
+  if (displayNeedsUpdate) scheduler.runIn(displayTaskId, DISPLAY_BUSY_RETRY);
+  LOG_D("DISP", "screen updated");
+}
+
+#if MEMORY_MONITOR_ENABLED
+void taskMemory() {
+  memory.check();
+}
+#endif
+
+// Отложенное сохранение настроек
+void taskStorage() {
+  if (!storage.isSavePending()) return;
+  PROFILE_SCOPE(PROF_SAVE);
+  storage.tick();
+}
+
+void taskAutosave() {
+  PROFILE_SCOPE(PROF_SAVE);
+  storage.saveDirect();
+}
+
+// Команды по Serial:
+//   d - статистика времени выполнения участков и задач (PROFILER_ENABLED)
+//   r - сброс статистики (PROFILER_ENABLED)
+//   p - доля времени бодрствования процессора
+//   b - замер отрисовки экранов (DISPLAY_BENCH_ENABLED)
+//   m - стек, свободная SRAM и размеры модулей (MEMORY_MONITOR_ENABLED)
+// Ответы на команды выводятся напрямую (блокирующе), минуя журнал
+void taskSerial() {
+  while (Serial.available() > 0) {
+    char cmd = Serial.read();
+    switch (cmd) {
+      case 'd':
+        #if PROFILER_ENABLED
+          profiler.dump(Serial);
+          for (uint8_t i = 0; i < scheduler.getTaskCount(); i++) {
+            const Task& t = scheduler.getTask(i);
+            Serial.print(F("TASK")); Serial.print(i);
+            Serial.print(F(" last=")); Serial.print(t.runTime);
+            Serial.print(F(" max=")); Serial.println(t.maxRunTime);
+          }
+        #endif
+        #if LOG_LEVEL > LOG_LEVEL_NONE
+          Serial.print(F("LOG dropped=")); Serial.println(logger.getDropped());
+        #endif
+        break;
+      #if PROFILER_ENABLED
+      case 'r':
+        profiler.reset();
+        Serial.println(F("DIAG reset"));
+        break;
+      #endif
+      case 'p':
+        power.printStats(Serial);
+        break;
+      #if MEMORY_MONITOR_ENABLED
+      case 'm':
+        memory.dump(Serial);
+        break;
+      #endif
+      #if DISPLAY_BENCH_ENABLED
+      case 'b':
+        // Меню не трогаем: замер рисует поверх и сбивает его состояние
+        if (menu.isActive()) break;
+        displayBench.run(Serial, DISPLAY_BENCH_REPEATS);
+        display.invalidate();
+        displayNeedsUpdate = true;
+        break;
+      #endif
+    }
+  }
+}
 
 void setup() {
-  // Сначала Serial для отладки
+  // Сначала Serial для отладки. До конца setup() журнал ждет UART,
+  // а не отбрасывает строки
   Serial.begin(115200);
-  Serial.println("=== Humidifier v1.9 ===");
+  #if LOG_LEVEL > LOG_LEVEL_NONE
+    logger.setBlocking(true);
+  #endif
+  LOG_I("MAIN", "Humidifier v" FIRMWARE_VERSION);
   
   wdt_disable();
-  Serial.println("1. Watchdog disabled");
+  LOG_D("MAIN", "watchdog disabled");
   
-  // Сначала инициализируем датчик DHT22
+  // Сначала инициализируем датчики. Датчикам на I2C шину запустит
+  // дисплей - первый замер все равно через UPDATE_INTERVAL
+  #if SENSOR_DHT22_ENABLED
+    dhtSensor.begin();
+    sensor.addDriver(&dhtSensor, FLASH_NAME(sensorNameDht));
+  #endif
+  #if DHT2_PIN
+    dht2Sensor.begin();
+    sensor.addDriver(&dht2Sensor, FLASH_NAME(sensorNameDht2));
+  #endif
+  #if SENSOR_SHT31_ENABLED
+    shtSensor.begin(&i2cBus);
+    sensor.addDriver(&shtSensor, FLASH_NAME(sensorNameSht));
+  #endif
+  #if SENSOR_BME280_ENABLED
+    bmeSensor.begin(&i2cBus);
+    sensor.addDriver(&bmeSensor, FLASH_NAME(sensorNameBme));
+  #endif
   sensor.begin();
-  Serial.println("2. Sensor begin");
+  lastMeasureTime = millis();
+  LOG_D("MAIN", "sensor begin");
   
   // Затем загружаем настройки
   storage.begin();
-  Serial.println("3. Storage begin");
+  LOG_D("MAIN", "storage begin");
   
   // Передаем storage датчику после загрузки
   sensor.setStorage(&storage);
-  Serial.println("4. Storage linked to sensor");
+  LOG_D("MAIN", "storage linked to sensor");
   
   // Дисплей
-  display.begin();
-  Serial.println("5. Display begin");
+  display.begin(&i2cBus);
+  display.setStorage(&storage);
+  display.setSensor(&sensor);
+  LOG_D("MAIN", "display begin");
   
   display.showSplash();
-  Serial.println("6. Splash shown");
+  LOG_D("MAIN", "splash shown");
   delay(1500);
-  Serial.println("7. Delay done");
+  LOG_D("MAIN", "delay done");
   
+  #if HISTORY_ENABLED
+    history.begin();
+    display.setHistory(&history);
+  #endif
+
   // Аналитика
   analytics.begin();
-  Serial.println("8. Analytics begin");
+  LOG_D("MAIN", "analytics begin");
   
   // Энкодер
   encoder.begin();
-  Serial.println("9. Encoder begin");
+  LOG_D("MAIN", "encoder begin");
   
   // Увлажнитель
   humidifier.begin();
   humidifier.setStorage(&storage);
-  Serial.println("10. Humidifier begin");
+  LOG_D("MAIN", "humidifier begin");
   
   // Меню
   menu.begin(&display, &encoder, &storage, &sensor, &humidifier);
   menu.setAnalytics(&analytics);
-  Serial.println("11. Menu begin");
+  #if PROFILER_ENABLED
+    menu.setProfiler(&profiler);
+  #endif
+  #if MEMORY_MONITOR_ENABLED
+    memory.setModules(memoryModules, sizeof(memoryModules) / sizeof(memoryModules[0]));
+    menu.setMemory(&memory);
+  #endif
+  LOG_D("MAIN", "menu begin");
+
+  #if DISPLAY_BENCH_ENABLED
+    displayBench.begin(&display, &menu);
+  #endif
   
   wdt_enable(WDTO_4S);
-  Serial.println("12. Watchdog enabled");
+  LOG_D("MAIN", "watchdog enabled");
   
-  lastEncoderActivity = millis();
-  lastDisplayUpdate = millis();
-  Serial.println("=== SETUP COMPLETE ===");
-}
-
-void loop() {
-  wdt_reset();
-  encoder.tick();
-  
-  // Яркость
-  if (encoder.isPress()) {
-    lastEncoderActivity = millis();
-    display.setBrightness(BRIGHTNESS_FULL);
-  }
-  unsigned long inactiveTime = millis() - lastEncoderActivity;
-  if (inactiveTime >= DIM_TIMEOUT_2) display.setBrightness(BRIGHTNESS_DIM2);
-  else if (inactiveTime >= DIM_TIMEOUT_1) display.setBrightness(BRIGHTNESS_DIM1);
+  // Порядок регистрации = порядок выполнения в пределах одного прохода
+  inputTaskId = scheduler.addTask(taskInput, ENCODER_POLL_INTERVAL);
+  #if WATER_SENSOR_ENABLED
+    scheduler.addTask(taskWater, WATER_CHECK_INTERVAL);
+  #endif
+  sensorTaskId = scheduler.addTask(taskSensor, UPDATE_INTERVAL);
+  #if WINDOW_DETECTOR_ENABLED
+    scheduler.addTask(taskWindow, WINDOW_CHECK_INTERVAL, WINDOW_CHECK_INTERVAL);
+  #endif
+  displayTaskId = scheduler.addTask(taskDisplay, DISPLAY_UPDATE_INTERVAL);
+  scheduler.addTask(taskStorage, EEPROM_SAVE_INTERVAL, EEPROM_SAVE_INTERVAL);
+  scheduler.addTask(taskAutosave, AUTOSAVE_INTERVAL, AUTOSAVE_INTERVAL);
+  scheduler.addTask(taskSerial, SERIAL_POLL_INTERVAL);
+  #if MEMORY_MONITOR_ENABLED
+    scheduler.addTask(taskMemory, MEMORY_CHECK_INTERVAL);
+  #endif
+  LOG_D("MAIN", "scheduler ready");
 
-  storage.tick();
+  power.begin();
+  LOG_D("MAIN", "power begin");
 
-  // Обновление данных
-  if (millis() - lastUpdateTime >= UPDATE_INTERVAL) {
-    lastUpdateTime = millis();
-    
-    Serial.print("Update - DHT22: ");
-    bool sensorOK = sensor.update();
-    Serial.println(sensorOK ? "OK" : "FAIL");
-    
-    float temp = sensor.getTemperature();
-    float hum = sensor.getHumidity();
-    Serial.print("Temp: "); Serial.print(temp);
-    Serial.print(" Hum: "); Serial.println(hum);
-    
-    bool running = humidifier.isRunning();
-
-    bool waterOK = true;
-    bool windowOpen = false;
-    
-    #if WATER_SENSOR_ENABLED
-      waterOK = analytics.checkWaterLevel();
-    #endif
-    
-    #if WINDOW_DETECTOR_ENABLED
-      analytics.updateWindowDetector(temp);
-      windowOpen = analytics.isWindowOpen();
-    #endif
-
-    display.addGraphPoint(hum, running);
-    
-    #if STATS_ENABLED
-      analytics.addSample(temp, hum, running);
-    #endif
-
-    if (waterOK && !windowOpen) {
-      humidifier.control(hum, storage.getMinHumidity(), storage.getMaxHumidity(), sensor.isOK());
-    } else {
-      humidifier.stop();
-    }
-
-    if (humidifier.isRunning()) {
-      storage.incrementWorkTime(UPDATE_INTERVAL / 1000);
-    }
-    
-    // Данные обновились - нужно перерисовать экран
-    displayNeedsUpdate = true;
-  }
-
-  // Двойной клик - вход/выход из меню
-  if (encoder.isDouble()) {
-    Serial.println("DOUBLE CLICK");
-    if (menu.isActive()) {
-      menu.close();
-    } else {
-      menu.open();
-    }
-  }
+  LOG_I("MAIN", "setup complete");
+  #if LOG_LEVEL > LOG_LEVEL_NONE
+    logger.setBlocking(false);
+  #endif
+}
 
-  // Меню
-  if (menu.isActive()) {
-    menu.tick();
-    menu.draw();
-  } else {
-    // Главный экран - переключение экранов только при вращении вправо
-    if (encoder.isRight()) {
-      Serial.println("RIGHT");
-      if (display.getMode() == MODE_GRAPH) {
-        display.toggleGraphScreen();
-      } else {
-        display.toggleMode();
-      }
-      displayNeedsUpdate = true;
-    }
-    
-    // Обновляем экран только если нужно
-    if (displayNeedsUpdate && millis() - lastDisplayUpdate >= 500) {
-      lastDisplayUpdate = millis();
-      
-      #if WATER_SENSOR_ENABLED
-        bool waterLow = analytics.isWaterLow();
-        bool waterSensorPresent = analytics.isWaterSensorPresent();
-        uint8_t waterPercent = analytics.getWaterPercent();
-        int waterRawValue = analytics.getWaterRawValue();
-      #else
-        bool waterLow = false;
-        bool waterSensorPresent = false;
-        uint8_t waterPercent = 0;
-        int waterRawValue = 0;
-      #endif
-      
-      #if WINDOW_DETECTOR_ENABLED
-        bool windowOpen = analytics.isWindowOpen();
-      #else
-        bool windowOpen = false;
-      #endif
-      
-      display.drawMainScreen(
-        sensor.getTemperature(),
-        sensor.getHumidity(),
-        storage.getMaxHumidity(),
-        humidifier.isRunning(),
-        storage.getWorkTime(),
-        sensor.isOK(),
-        waterLow,
-        windowOpen,
-        waterSensorPresent,
-        waterPercent,
-        waterRawValue
-      );
-      displayNeedsUpdate = false;
-      Serial.println("Screen updated");
-    }
-  }
+// Условие досрочного пробуждения: событие энкодера или место
+// в очереди I2C под следующую страницу кадра
+bool wakeOnInput() {
+  return encoder.hasEvent() || display.needsPump();
+}
 
-  if (millis() - lastSaveTime >= AUTOSAVE_INTERVAL) {
-    lastSaveTime = millis();
-    storage.saveDirect();
+void loop() {
+  wdt_reset();
+  {
+    PROFILE_SCOPE(PROF_LOOP);
+    scheduler.tick();
   }
+  LOG_FLUSH();
+  display.pump();
 
-  delay(10);
+  // Спим до ближайшего срока; событие энкодера обрабатываем сразу
+  power.idle(scheduler.timeToNext(), wakeOnInput);
+  if (encoder.hasEvent()) scheduler.runIn(inputTaskId, 0);
 }
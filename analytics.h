@@ -6,9 +6,10 @@
 #ifndef ANALYTICS_H
 #define ANALYTICS_H
 
-#include <Arduino.h>
-#include <EEPROM.h>
+#include "hal.h"
 #include "config.h"
+#include "log.h"
+#include "fixed.h"
 
 class Analytics {
 private:
@@ -16,25 +17,23 @@ private:
   uint16_t tempSum;
   uint16_t humSum;
   uint8_t sampleCount;
-  uint8_t hourRunTime;
+  unsigned long hourRunTime;  // мс работы увлажнителя за час
   
-  float baselineTemp;
+  Deci baselineTemp;
   uint8_t tempDropCount;
   bool windowOpen;
-  unsigned long lastWindowCheck;
   
   bool waterLow;
   bool waterSensorPresent;
-  unsigned long lastWaterCheck;
   uint8_t waterStableCount;
   int lastWaterValue;
   uint16_t waterThreshold;
 
 public:
   Analytics() : currentHour(255), tempSum(0), humSum(0), sampleCount(0),
-                hourRunTime(0), baselineTemp(20.0), tempDropCount(0),
-                windowOpen(false), lastWindowCheck(0), waterLow(false),
-                waterSensorPresent(false), lastWaterCheck(0), waterStableCount(0),
+                hourRunTime(0), baselineTemp(DECI(20)), tempDropCount(0),
+                windowOpen(false), waterLow(false),
+                waterSensorPresent(false), waterStableCount(0),
                 lastWaterValue(0), waterThreshold(WATER_THRESHOLD) {}
 
   void begin() {
@@ -88,18 +87,21 @@ public:
   
   int getWaterRawValue() const { return lastWaterValue; }
   
+  // Вызывается планировщиком раз в WATER_CHECK_INTERVAL
   bool checkWaterLevel() {
     if (!waterSensorPresent) return true;
-    if (millis() - lastWaterCheck < 1000) return !waterLow;
-    
-    lastWaterCheck = millis();
+
     int level = readWaterSensor();
     lastWaterValue = level;
     
     bool nowLow = (level < waterThreshold);
     if (nowLow != waterLow) {
       waterStableCount++;
-      if (waterStableCount >= 3) { waterLow = nowLow; waterStableCount = 0; }
+      if (waterStableCount >= 3) {
+        waterLow = nowLow;
+        waterStableCount = 0;
+        LOG_I("WATR", "level %s (%d)", waterLow ? "low" : "ok", level);
+      }
     } else {
       waterStableCount = 0;
     }
@@ -109,32 +111,33 @@ public:
   bool isWaterLow() const { return waterLow && waterSensorPresent; }
   bool isWaterSensorPresent() const { return waterSensorPresent; }
 
-  void updateWindowDetector(float temp) {
-    unsigned long now = millis();
-    if (now - lastWindowCheck < WINDOW_CHECK_INTERVAL) return;
-    lastWindowCheck = now;
-    
+  // Вызывается планировщиком раз в WINDOW_CHECK_INTERVAL
+  void updateWindowDetector(Deci temp) {
     if (baselineTemp - temp >= WINDOW_TEMP_DROP) {
       tempDropCount++;
-      if (tempDropCount >= WINDOW_TEMP_SAMPLES) windowOpen = true;
+      if (tempDropCount >= WINDOW_TEMP_SAMPLES && !windowOpen) {
+        windowOpen = true;
+        LOG_I("WIN", "window open");
+      }
     } else {
-      if (temp >= baselineTemp - 0.5) { tempDropCount = 0; windowOpen = false; baselineTemp = temp; }
+      if (temp >= baselineTemp - DECI(0.5)) { tempDropCount = 0; windowOpen = false; baselineTemp = temp; }
     }
   }
   
   bool isWindowOpen() const { return windowOpen; }
 
-  void addSample(float temp, float hum, bool running) {
+  // elapsed - мс с прошлого замера: период замеров переменный
+  void addSample(Deci temp, Deci hum, bool running, unsigned long elapsed) {
     uint8_t hour = (millis() / 3600000UL) % 24;
     if (hour != currentHour && sampleCount > 0) {
       saveHourlyStats();
       currentHour = hour; tempSum = 0; humSum = 0; sampleCount = 0; hourRunTime = 0;
     }
     currentHour = hour;
-    tempSum += (uint8_t)constrain(temp + 50, 0, 100);
-    humSum += (uint8_t)constrain(hum, 0, 100);
+    tempSum += deciTrunc(constrain(temp + DECI(50), 0, DECI(100)));
+    humSum += deciTrunc(constrain(hum, 0, DECI(100)));
     sampleCount++;
-    if (running) hourRunTime++;
+    if (running) hourRunTime += elapsed;
   }
   
   void saveHourlyStats() {
@@ -143,7 +146,7 @@ public:
     Stats s;
     s.t = tempSum / sampleCount;
     s.h = humSum / sampleCount;
-    s.r = min(hourRunTime / 30, 60);
+    s.r = min(hourRunTime / 60000UL, 60UL);  // Минуты работы
     s.s = 0;
     int addr = EEPROM_STATS_ADDR + (currentHour * 4);
     EEPROM.put(addr, s);
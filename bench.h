@@ -0,0 +1,176 @@
+/*
+ * ЗАМЕР ОТРИСОВКИ ЭКРАНОВ
+ * Каждый экран рисуется с одними и теми же тестовыми данными, время
+ * по micros(). На Nano - команда 'b' в Serial, на ПК - display_bench
+ * (host/bench.cpp), который вдобавок считает байты на шине I2C.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "hal.h"
+#include "config.h"
+#include "display.h"
+#include "menu.h"
+
+enum BenchCase {
+  BENCH_CLEAR = 0,       // clear() + update() - пустой кадр
+  BENCH_DATA = 1,        // drawDataScreen(), режим данных
+  BENCH_DATA_GRAPH = 2,  // drawDataScreen(), режим графика
+  BENCH_GRAPH = 3,       // drawGraph() без очистки экрана
+  BENCH_STATS = 4,       // drawStatsScreen()
+  BENCH_ABOUT = 5,       // drawAboutScreen()
+  BENCH_MENU = 6,        // Menu::drawMenuScreen()
+  BENCH_TICK = 7,        // drawMainScreen(): влажность изменилась на 1%
+  BENCH_GRAPH_STEP = 8,  // Новая точка графика: updateGraph()
+  BENCH_STATS_TICK = 9,  // Статистика: влажность и минута работы изменились
+  BENCH_MENU_STEP = 10,  // Меню: курсор на пункт вниз
+  BENCH_COUNT = 11
+};
+
+class DisplayBench {
+private:
+  Display* display;
+  Menu* menu;
+
+  void drawData() {
+    display->drawDataScreen(DECI(22.5), DECI(45), 60, true, 5000, true,
+                            false, true, 75, 600);
+  }
+
+  void drawMain(Deci hum) {
+    display->drawMainScreen(DECI(22.5), hum, 60, true, 5000, true,
+                            false, false, true, 75, 600);
+  }
+
+public:
+  DisplayBench() : display(nullptr), menu(nullptr) {}
+
+  void begin(Display* disp, Menu* m) {
+    display = disp;
+    menu = m;
+  }
+
+  static const __FlashStringHelper* getName(uint8_t c) {
+    switch (c) {
+      case BENCH_CLEAR: return F("CLEAR");
+      case BENCH_DATA: return F("DATA");
+      case BENCH_DATA_GRAPH: return F("DATA+G");
+      case BENCH_GRAPH: return F("GRAPH");
+      case BENCH_STATS: return F("STATS");
+      case BENCH_ABOUT: return F("ABOUT");
+      case BENCH_MENU: return F("MENU");
+      case BENCH_TICK: return F("TICK");
+      case BENCH_GRAPH_STEP: return F("G_STEP");
+      case BENCH_STATS_TICK: return F("S_TICK");
+      case BENCH_MENU_STEP: return F("M_STEP");
+    }
+    return F("?");
+  }
+
+  // Пила 30..70% с включениями увлажнителя - график во всю ширину.
+  // Затирает накопленную историю, поэтому только для прогона на ПК
+  void fillGraph() {
+    for (uint8_t i = 0; i < GRAPH_POINTS; i++) {
+      uint8_t phase = i % 16;
+      Deci hum = DECI(30) + (phase < 8 ? phase : 16 - phase) * DECI(5);
+      display->addGraphPoint(hum, phase < 8, DECI(21) + phase * DECI(0.5) / 2);
+    }
+  }
+
+  // Подготовка экрана перед замером, в замер не входит
+  void prepare(uint8_t c) {
+    if (c == BENCH_TICK) {
+      if (display->getMode() == MODE_GRAPH) display->toggleMode();
+      drawMain(DECI(45));
+    }
+    if (c == BENCH_GRAPH_STEP) display->drawGraph();
+    if (c == BENCH_STATS_TICK)
+      display->drawStatsScreen(DECI(22.5), DECI(45), true, 5000, false, true, 75);
+    if (c == BENCH_MENU_STEP) menu->drawMenuScreen();
+    display->flush();
+  }
+
+  // Одна отрисовка экрана. Режим дисплея восстанавливается.
+  // Замер длится, пока кадр не уйдет на шину целиком
+  void draw(uint8_t c) {
+    switch (c) {
+      case BENCH_CLEAR:
+        display->clear();
+        display->update();
+        break;
+      case BENCH_DATA:
+        if (display->getMode() == MODE_GRAPH) display->toggleMode();
+        drawData();
+        break;
+      case BENCH_DATA_GRAPH:
+        if (display->getMode() == MODE_DATA) display->toggleMode();
+        drawData();
+        display->toggleMode();
+        break;
+      case BENCH_GRAPH:
+        display->drawGraph();
+        break;
+      case BENCH_STATS:
+        display->drawStatsScreen(DECI(22.5), DECI(45), true, 5000, false, true, 75);
+        break;
+      case BENCH_ABOUT:
+        display->drawAboutScreen(5000, 3, 1234, true, WATER_THRESHOLD, 600);
+        break;
+      case BENCH_MENU:
+        menu->drawMenuScreen();
+        break;
+      case BENCH_TICK:
+        drawMain(DECI(46));
+        break;
+      case BENCH_GRAPH_STEP:
+        // Добавляет в историю тестовую точку
+        display->addGraphPoint(DECI(50), false, DECI(22.5));
+        display->updateGraph();
+        break;
+      case BENCH_STATS_TICK:
+        display->updateStatsFields(true, DECI(22.5), DECI(46), true, 5060, false, true, 75);
+        break;
+      case BENCH_MENU_STEP:
+        menu->handleEvent(ENC_EVENT_RIGHT);
+        menu->updateMenuScreen();
+        break;
+    }
+    display->flush();
+  }
+
+  // Тестовая точка графика, курсор меню и режим дисплея после замера
+  // возвращаются: на Nano замер идет посреди настоящей истории
+  unsigned long measure(uint8_t c) {
+    Display::BenchState state = display->saveBenchState();
+    uint8_t item = menu->getCurrentItem();
+    prepare(c);
+    unsigned long start = micros();
+    draw(c);
+    unsigned long us = micros() - start;
+    display->restoreBenchState(state);
+    menu->setCurrentItem(item);
+    return us;
+  }
+
+  // repeats отрисовок каждого экрана: среднее и максимум, мкс.
+  // Экран после замера испорчен - вызывающий перерисовывает его
+  void run(Print& out, uint8_t repeats) {
+    if (repeats == 0) repeats = 1;
+    out.println(F("=== BENCH, us ==="));
+    for (uint8_t c = 0; c < BENCH_COUNT; c++) {
+      unsigned long sum = 0, maxUs = 0;
+      for (uint8_t i = 0; i < repeats; i++) {
+        wdt_reset();
+        unsigned long us = measure(c);
+        sum += us;
+        if (us > maxUs) maxUs = us;
+      }
+      out.print(getName(c));
+      out.print(F(" avg=")); out.print(sum / repeats);
+      out.print(F(" max=")); out.println(maxUs);
+    }
+  }
+};
+
+#endif // BENCH_H
@@ -0,0 +1,210 @@
+/*
+ * ДРАЙВЕР BME280 (I2C)
+ * Принудительный режим: запись ctrl_hum/ctrl_meas запускает один
+ * замер температуры и влажности (давление не измеряется), флаг
+ * measuring в регистре status опрашивается, пока замер не
+ * закончится, затем читаются 5 байт АЦП. Коэффициенты калибровки
+ * читаются перед первым замером, пересчет - целочисленные формулы
+ * из даташита. Обмен - через очередь I2C дисплея (twi.h)
+ */
+
+#ifndef BME280_H
+#define BME280_H
+
+#include "hal.h"
+#include "config.h"
+#include "sensor_driver.h"
+#include "twi.h"
+
+#define BME280_REG_CALIB_T   0x88  // dig_T1..dig_T3, 6 байт
+#define BME280_REG_CALIB_H1  0xA1
+#define BME280_REG_CALIB_H   0xE1  // dig_H2..dig_H6, 7 байт
+#define BME280_REG_CTRL_HUM  0xF2
+#define BME280_REG_STATUS    0xF3
+#define BME280_REG_CTRL_MEAS 0xF4
+#define BME280_REG_DATA_T    0xFA  // temp_msb..hum_lsb, 5 байт
+
+#define BME280_STATUS_MEASURING 0x08
+#define BME280_CTRL_HUM      0x01  // osrs_h x1
+#define BME280_CTRL_MEAS     0x21  // osrs_t x1, давление выкл., forced
+
+enum Bme280State {
+  BME280_STATE_IDLE = 0,
+  BME280_STATE_CALIB_T = 1,
+  BME280_STATE_CALIB_H1 = 2,
+  BME280_STATE_CALIB_H = 3,
+  BME280_STATE_TRIGGER = 4,   // Запуск замера ждет места в очереди
+  BME280_STATE_MEASURE = 5,   // Не раньше BME280_MEASURE_TIME
+  BME280_STATE_STATUS = 6,    // Опрос флага measuring
+  BME280_STATE_DATA = 7
+};
+
+class Bme280 : public SensorDriver {
+private:
+  TwiQueue* bus;
+  uint8_t buf[7];
+  uint8_t state;
+  bool requested;           // Чтение для текущего состояния в очереди
+  bool calibrated;
+  unsigned long stateTime;  // Запуск замера - отсчет таймаута
+  unsigned long triggerTime;
+
+  uint16_t digT1;
+  int16_t digT2, digT3;
+  uint8_t digH1, digH3;
+  int16_t digH2, digH4, digH5;
+  int8_t digH6;
+
+  // Адрес регистра и чтение n байт подряд. false - в очереди нет
+  // места или занято чтение, повтор на следующем шаге
+  bool request(uint8_t reg, uint8_t n) {
+    if (bus->space() < 5 || bus->getReadState() == TWI_READ_PENDING) return false;
+    bus->beginTransmission(BME280_ADDRESS);
+    bus->write(reg);
+    bus->endTransmission();
+    bus->requestFrom(BME280_ADDRESS, buf, n);
+    requested = true;
+    return true;
+  }
+
+  static uint16_t le16(const uint8_t* p) { return p[0] | ((uint16_t)p[1] << 8); }
+
+  // Даташит, BME280_compensate_T_int32 и bme280_compensate_H_int32:
+  // температура в 0,01 °C, влажность в 1/1024 %
+  void compensate() {
+    int32_t adcT = ((int32_t)buf[0] << 12) | ((int32_t)buf[1] << 4) | (buf[2] >> 4);
+    int32_t adcH = ((int32_t)buf[3] << 8) | buf[4];
+
+    int32_t var1 = ((((adcT >> 3) - ((int32_t)digT1 << 1))) * digT2) >> 11;
+    int32_t var2 = (adcT >> 4) - (int32_t)digT1;
+    var2 = (((var2 * var2) >> 12) * digT3) >> 14;
+    int32_t tFine = var1 + var2;
+    int32_t t100 = (tFine * 5 + 128) >> 8;
+
+    int32_t v = tFine - 76800;
+    v = (((adcH << 14) - ((int32_t)digH4 << 20) - ((int32_t)digH5 * v) + 16384) >> 15) *
+        (((((((v * digH6) >> 10) * (((v * (int32_t)digH3) >> 11) + 32768)) >> 10) +
+           2097152) * digH2 + 8192) >> 14);
+    v -= ((((v >> 15) * (v >> 15)) >> 7) * (int32_t)digH1) >> 4;
+    if (v < 0) v = 0;
+    if (v > 419430400) v = 419430400;
+    uint32_t h1024 = (uint32_t)v >> 12;
+
+    temperature = (Deci)((t100 + (t100 < 0 ? -5 : 5)) / 10);
+    humidity = (Deci)((h1024 * 10 + 512) >> 10);
+  }
+
+  // Прочитанное для текущего состояния: следующий шаг
+  uint8_t onRead() {
+    switch (state) {
+      case BME280_STATE_CALIB_T:
+        digT1 = le16(buf);
+        digT2 = (int16_t)le16(buf + 2);
+        digT3 = (int16_t)le16(buf + 4);
+        state = BME280_STATE_CALIB_H1;
+        break;
+      case BME280_STATE_CALIB_H1:
+        digH1 = buf[0];
+        state = BME280_STATE_CALIB_H;
+        break;
+      case BME280_STATE_CALIB_H:
+        // dig_H4 и dig_H5 - 12 бит со знаком, делят 0xE5 пополам
+        digH2 = (int16_t)le16(buf);
+        digH3 = buf[2];
+        digH4 = (int16_t)(int8_t)buf[3] * 16 | (buf[4] & 0x0F);
+        digH5 = (int16_t)(int8_t)buf[5] * 16 | (buf[4] >> 4);
+        digH6 = (int8_t)buf[6];
+        calibrated = true;
+        state = BME280_STATE_TRIGGER;
+        break;
+      case BME280_STATE_STATUS:
+        if (!(buf[0] & BME280_STATUS_MEASURING)) state = BME280_STATE_DATA;
+        break;
+      case BME280_STATE_DATA:
+        compensate();
+        state = BME280_STATE_IDLE;
+        return SENSOR_OK;
+    }
+    return SENSOR_BUSY;
+  }
+
+public:
+  Bme280() : SensorDriver(BME280_MIN_INTERVAL, BME280_POLL_INTERVAL),
+             bus(nullptr), state(BME280_STATE_IDLE), requested(false),
+             calibrated(false), stateTime(0), triggerTime(0),
+             digT1(0), digT2(0), digT3(0), digH1(0), digH3(0),
+             digH2(0), digH4(0), digH5(0), digH6(0) {}
+
+  // Шину запускает дисплей, до первого замера
+  void begin(TwiQueue* twi) {
+    bus = twi;
+  }
+
+  bool start() override {
+    if (state != BME280_STATE_IDLE || bus == nullptr) return false;
+    state = calibrated ? BME280_STATE_TRIGGER : BME280_STATE_CALIB_T;
+    stateTime = millis();
+    return true;
+  }
+
+  uint8_t poll() override {
+    if (state == BME280_STATE_IDLE) return SENSOR_BUSY;
+
+    if (requested) {
+      uint8_t read = bus->getReadState();
+      if (read == TWI_READ_PENDING) {
+        if (millis() - stateTime < BME280_TIMEOUT) return SENSOR_BUSY;
+        state = BME280_STATE_IDLE;
+        return SENSOR_ERROR_TIMEOUT;
+      }
+      requested = false;
+      if (read != TWI_READ_DONE) {
+        state = BME280_STATE_IDLE;
+        return SENSOR_ERROR_BUS;
+      }
+      return onRead();
+    }
+
+    if (millis() - stateTime >= BME280_TIMEOUT) {
+      state = BME280_STATE_IDLE;
+      return SENSOR_ERROR_TIMEOUT;
+    }
+
+    switch (state) {
+      case BME280_STATE_CALIB_T:
+        request(BME280_REG_CALIB_T, 6);
+        break;
+      case BME280_STATE_CALIB_H1:
+        request(BME280_REG_CALIB_H1, 1);
+        break;
+      case BME280_STATE_CALIB_H:
+        request(BME280_REG_CALIB_H, 7);
+        break;
+      case BME280_STATE_TRIGGER:
+        // Пары "регистр, значение" одной транзакцией: ctrl_hum
+        // вступает в силу только после записи ctrl_meas
+        if (bus->space() < 6) break;
+        bus->beginTransmission(BME280_ADDRESS);
+        bus->write(BME280_REG_CTRL_HUM);
+        bus->write(BME280_CTRL_HUM);
+        bus->write(BME280_REG_CTRL_MEAS);
+        bus->write(BME280_CTRL_MEAS);
+        bus->endTransmission();
+        triggerTime = millis();
+        state = BME280_STATE_MEASURE;
+        break;
+      case BME280_STATE_MEASURE:
+        if (millis() - triggerTime >= BME280_MEASURE_TIME) state = BME280_STATE_STATUS;
+        break;
+      case BME280_STATE_STATUS:
+        request(BME280_REG_STATUS, 1);
+        break;
+      case BME280_STATE_DATA:
+        request(BME280_REG_DATA_T, 5);
+        break;
+    }
+    return SENSOR_BUSY;
+  }
+};
+
+#endif // BME280_H
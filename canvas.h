@@ -0,0 +1,369 @@
+/*
+ * ПОСТРАНИЧНАЯ ОТРИСОВКА КАДРА
+ * Буфер кадра (1 КБ) в Nano не помещается, поэтому кадр собирается по
+ * одной странице SSD1306 (128 байт): операции рисования сначала только
+ * записываются в короткий список, а renderPage() для каждой страницы
+ * проигрывает весь список в буфер страницы и отправляет ее одним окном.
+ * Текст, линии и график накладываются друг на друга правильно, экран
+ * не мигает, и каждый байт кадра уходит на шину ровно один раз.
+ *
+ * Страницы можно отправлять по одной (renderPage) - так Display не
+ * держит loop(), пока кадр уходит на шину.
+ *
+ * Методы повторяют подмножество GyverOLED, которое используют экраны.
+ * Строки не копируются: print(const char*) запоминает указатель, строка
+ * должна жить до отправки кадра (литералы и таблицы меню живут всегда)
+ */
+
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include "hal.h"
+#include "config.h"
+#include "log.h"
+
+#define CANVAS_WIDTH   128
+#define CANVAS_PAGES   8
+#define CANVAS_INVERT  0x80   // Флаг инверсии в arg текстовой операции
+#define CANVAS_XOR     3      // Заливка rect(): инверсия уже нарисованного
+
+enum CanvasOpType {
+  CANVAS_TEXT = 0,     // Строка в RAM
+  CANVAS_TEXT_P = 1,   // Строка во flash
+  CANVAS_NUMBER = 2,   // Число int16_t
+  CANVAS_LINE = 3,
+  CANVAS_RECT = 4,
+  CANVAS_COLUMNS = 5,  // Байты столбцов от источника (график)
+  CANVAS_NUMBER_LONG = 6,  // Младшие 16 бит числа, старшие - в следующей
+  CANVAS_NUMBER_HIGH = 7   // Старшие 16 бит, сама не рисуется
+};
+
+// Байт страницы page для столбца x
+typedef uint8_t (*CanvasSource)(const void* ctx, uint8_t x, uint8_t page);
+
+struct CanvasPoint {
+  uint8_t x, y;
+};
+
+struct CanvasOp {
+  uint8_t type;   // CanvasOpType
+  uint8_t x, y;   // Пиксели: начало текста, линии, угол прямоугольника
+  uint8_t arg;    // Текст: масштаб | CANVAS_INVERT; линия, прямоугольник: заливка
+  union {
+    const char* text;
+    int16_t number;
+    CanvasPoint end;      // Второй конец линии, угол прямоугольника
+    CanvasSource source;  // Столбцы x..arg, страницы y..7
+  };
+};
+
+class PageCanvas {
+private:
+  CanvasOp ops[CANVAS_OPS];
+  uint8_t count;
+  uint8_t dropped;      // Операций не поместилось, с последнего clear()
+  uint16_t overflows;   // Кадров с потерей операций за все время
+  const void* sourceCtx;
+
+  int16_t cursorX, cursorY;
+  uint8_t scale;
+  bool invert;
+
+  uint8_t page[CANVAS_WIDTH];
+
+  // Операция не поместилась: экран будет нарисован не весь.
+  // В журнал - один раз за кадр
+  void drop() {
+    if (dropped++) return;
+    if (overflows < 0xFFFF) overflows++;
+    LOG_W("CANV", "ops > %u", CANVAS_OPS);
+  }
+
+  CanvasOp* add(uint8_t type) {
+    if (count >= CANVAS_OPS) {
+      drop();
+      return nullptr;
+    }
+    CanvasOp* op = &ops[count++];
+    op->type = type;
+    op->x = constrain(cursorX, 0, 255);
+    op->y = constrain(cursorY, 0, 255);
+    op->arg = scale | (invert ? CANVAS_INVERT : 0);
+    return op;
+  }
+
+  static uint8_t clip(int v, int limit) {
+    return constrain(v, 0, limit);
+  }
+
+  // Символов в строке UTF-8: продолжения (10xxxxxx) не считаются
+  static uint8_t textChars(const char* s, bool progmem) {
+    uint8_t n = 0;
+    for (;; s++) {
+      uint8_t c = progmem ? pgm_read_byte(s) : *s;
+      if (!c) return n;
+      if ((c & 0xC0) != 0x80) n++;
+    }
+  }
+
+  static uint8_t numberChars(long v) {
+    uint8_t n = v < 0 ? 2 : 1;
+    unsigned long u = v < 0 ? -(unsigned long)v : v;
+    while (u >= 10) {
+      u /= 10;
+      n++;
+    }
+    return n;
+  }
+
+  void addText(const char* s, bool progmem) {
+    CanvasOp* op = add(progmem ? CANVAS_TEXT_P : CANVAS_TEXT);
+    if (op) op->text = s;
+    cursorX += textChars(s, progmem) * 6 * scale;
+  }
+
+  // Столбец шрифта 8 строк -> 8 * s строк
+  static uint32_t stretch(uint8_t bits, uint8_t s) {
+    if (s == 1) return bits;
+    uint32_t out = 0;
+    uint32_t unit = ((uint32_t)1 << s) - 1;
+    for (uint8_t b = 0; b < 8; b++) {
+      if (bits & (1 << b)) out |= unit << (b * s);
+    }
+    return out;
+  }
+
+  // Столбец высотой 8 * s строк, начиная со строки y, в байт страницы top
+  static uint8_t toPage(uint32_t bits, int16_t y, int16_t top) {
+    int16_t shift = y - top;
+    if (shift >= 0) return (uint8_t)(bits << shift);
+    if (shift <= -32) return 0;
+    return (uint8_t)(bits >> -shift);
+  }
+
+  // Код символа для getFont() как у GyverOLED::write(): из двух байт
+  // UTF-8 кириллицы остается второй; Ё и ё рисуются как Е и е
+  static uint8_t recode(uint8_t lead, uint8_t c) {
+    if (lead == 0xD0 && c == 0x81) return 0x95;
+    if (lead == 0xD1 && c == 0x91) return 0xB5;
+    return c;
+  }
+
+  template <class Oled>
+  void drawText(Oled& oled, const CanvasOp& op, const char* s, bool progmem, int16_t top) {
+    uint8_t s8 = op.arg & ~CANVAS_INVERT;
+    bool inv = op.arg & CANVAS_INVERT;
+    if (op.y >= top + 8 || op.y + 8 * s8 <= top) return;
+
+    uint32_t mask = s8 >= 4 ? 0xFFFFFFFFUL : ((uint32_t)1 << (8 * s8)) - 1;
+    uint8_t maskByte = toPage(mask, op.y, top);
+    int16_t x = op.x;
+    uint8_t lead = 0;
+    for (;; s++) {
+      uint8_t c = progmem ? pgm_read_byte(s) : *s;
+      if (!c) return;
+      if (c >= 0xC0) {
+        lead = c;
+        continue;
+      }
+      uint8_t code = c >= 0x80 ? recode(lead, c) : c;
+      lead = 0;
+
+      // Символ 5 столбцов + промежуток, заменяет фон в своей клетке
+      for (uint8_t col = 0; col < 6; col++) {
+        uint32_t bits = stretch(col < 5 ? oled.getFont(code, col) : 0, s8);
+        if (inv) bits = ~bits & mask;
+        uint8_t b = toPage(bits, op.y, top);
+        for (uint8_t i = 0; i < s8; i++, x++) {
+          if (x >= CANVAS_WIDTH) return;
+          page[x] = (page[x] & ~maskByte) | b;
+        }
+      }
+    }
+  }
+
+  void setPixel(int16_t x, int16_t y, int16_t top, uint8_t fill) {
+    if (x < 0 || x >= CANVAS_WIDTH || y < top || y >= top + 8) return;
+    if (fill) page[x] |= 1 << (y - top);
+    else page[x] &= ~(1 << (y - top));
+  }
+
+  // Брезенхэм по всей линии, в буфер попадают точки этой страницы
+  void drawLine(const CanvasOp& op, int16_t top) {
+    int16_t x0 = op.x, y0 = op.y, x1 = op.end.x, y1 = op.end.y;
+    if (max(y0, y1) < top || min(y0, y1) >= top + 8) return;
+    int16_t dx = abs(x1 - x0), dy = -abs(y1 - y0);
+    int8_t sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    int16_t err = dx + dy;
+    for (;;) {
+      setPixel(x0, y0, top, op.arg);
+      if (x0 == x1 && y0 == y1) return;
+      int16_t e2 = 2 * err;
+      if (e2 >= dy) { err += dy; x0 += sx; }
+      if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+  }
+
+  void drawRect(const CanvasOp& op, int16_t top) {
+    uint8_t bits = 0, edge = 0;
+    for (uint8_t b = 0; b < 8; b++) {
+      int16_t y = top + b;
+      if (y >= op.y && y <= op.end.y) bits |= 1 << b;
+      if (y == op.y || y == op.end.y) edge |= 1 << b;
+    }
+    if (!bits) return;
+    for (uint8_t x = op.x; x <= op.end.x && x < CANVAS_WIDTH; x++) {
+      if (op.arg == OLED_CLEAR) page[x] &= ~bits;
+      else if (op.arg == CANVAS_XOR) page[x] ^= bits;
+      else if (op.arg == OLED_FILL || x == op.x || x == op.end.x) page[x] |= bits;
+      else page[x] |= edge;
+    }
+  }
+
+public:
+  PageCanvas() : count(0), dropped(0), overflows(0), sourceCtx(nullptr), cursorX(0), cursorY(0),
+                 scale(1), invert(false) {}
+
+  // Новый кадр: пустой список
+  void clear() {
+    count = 0;
+    dropped = 0;
+    sourceCtx = nullptr;
+    cursorX = cursorY = 0;
+  }
+
+  void clear(int x0, int y0, int x1, int y1) { rect(x0, y0, x1, y1, OLED_CLEAR); }
+
+  void setCursor(int x, int row) {
+    cursorX = x;
+    cursorY = row << 3;
+  }
+  void setCursorXY(int x, int y) {
+    cursorX = x;
+    cursorY = y;
+  }
+  void setScale(uint8_t s) { scale = constrain(s, 1, 4); }
+  void invertText(bool inv) { invert = inv; }
+
+  void print(const char* s) { addText(s, false); }
+  void print(const __FlashStringHelper* s) { addText((const char*)s, true); }
+  // Число вне int16_t занимает две операции: поле операции - 2 байта,
+  // а большие числа (мкс, часы работы) редки
+  void print(long v) {
+    if (v >= -32768L && v <= 32767L) {
+      CanvasOp* op = add(CANVAS_NUMBER);
+      if (op) op->number = v;
+    } else if (count + 1 < CANVAS_OPS) {
+      add(CANVAS_NUMBER_LONG)->number = (int16_t)(v & 0xFFFF);
+      add(CANVAS_NUMBER_HIGH)->number = (int16_t)(v >> 16);
+    } else {
+      drop();
+    }
+    cursorX += numberChars(v) * 6 * scale;
+  }
+  void print(int v) { print((long)v); }
+  void print(unsigned int v) { print((long)v); }
+  void print(unsigned char v) { print((long)v); }
+  void print(unsigned long v) { print((long)min(v, 0x7FFFFFFFUL)); }
+
+  void line(int x0, int y0, int x1, int y1, uint8_t fill = 1) {
+    CanvasOp* op = add(CANVAS_LINE);
+    if (!op) return;
+    op->x = clip(x0, 127);
+    op->y = clip(y0, 63);
+    op->end.x = clip(x1, 127);
+    op->end.y = clip(y1, 63);
+    op->arg = fill;
+  }
+  void fastLineH(int y, int x0, int x1, uint8_t fill = 1) { line(x0, y, x1, y, fill); }
+  void fastLineV(int x, int y0, int y1, uint8_t fill = 1) { line(x, y0, x, y1, fill); }
+  void dot(int x, int y, uint8_t fill = 1) { line(x, y, x, y, fill); }
+
+  void rect(int x0, int y0, int x1, int y1, uint8_t fill = OLED_FILL) {
+    CanvasOp* op = add(CANVAS_RECT);
+    if (!op) return;
+    op->x = clip(min(x0, x1), 127);
+    op->y = clip(min(y0, y1), 63);
+    op->end.x = clip(max(x0, x1), 127);
+    op->end.y = clip(max(y0, y1), 63);
+    op->arg = fill;
+  }
+
+  // Столбцы x0..x1 страниц page0..7 целиком берутся из source.
+  // Источник в кадре один: ctx общий для всех таких операций
+  void columns(uint8_t x0, uint8_t x1, uint8_t page0, CanvasSource source, const void* ctx) {
+    CanvasOp* op = add(CANVAS_COLUMNS);
+    if (!op) return;
+    op->x = x0;
+    op->y = page0;
+    op->arg = x1;
+    op->source = source;
+    sourceCtx = ctx;
+  }
+
+  uint8_t getCount() const { return count; }
+  uint8_t getDropped() const { return dropped; }
+  uint16_t getOverflows() const { return overflows; }
+
+  // Собирает страницу p из всего списка и отправляет ее столбцы
+  // x0..x1 одним окном. Список сохраняется до следующего clear()
+  template <class Out>
+  void renderPage(Out& out, uint8_t p, uint8_t x0 = 0, uint8_t x1 = CANVAS_WIDTH - 1) {
+    char digits[12];
+    int16_t top = p * 8;
+    memset(page, 0, sizeof(page));
+    for (uint8_t i = 0; i < count; i++) {
+      const CanvasOp& op = ops[i];
+      switch (op.type) {
+        case CANVAS_TEXT:
+          drawText(out, op, op.text, false, top);
+          break;
+        case CANVAS_TEXT_P:
+          drawText(out, op, op.text, true, top);
+          break;
+        case CANVAS_NUMBER:
+        case CANVAS_NUMBER_LONG: {
+          int32_t v = op.number;
+          if (op.type == CANVAS_NUMBER_LONG && i + 1 < count)
+            v = (int32_t)(((uint32_t)(uint16_t)ops[i + 1].number << 16) | (uint16_t)op.number);
+          uint32_t u = v < 0 ? -(uint32_t)v : v;
+          uint8_t n = sizeof(digits) - 1;
+          digits[n] = 0;
+          do {
+            digits[--n] = '0' + u % 10;
+            u /= 10;
+          } while (u);
+          if (v < 0) digits[--n] = '-';
+          drawText(out, op, digits + n, false, top);
+          break;
+        }
+        case CANVAS_LINE:
+          drawLine(op, top);
+          break;
+        case CANVAS_RECT:
+          drawRect(op, top);
+          break;
+        case CANVAS_COLUMNS:
+          if (p < op.y) break;
+          for (uint8_t x = op.x; x <= op.arg && x < CANVAS_WIDTH; x++) {
+            page[x] = op.source(sourceCtx, x, p);
+          }
+          break;
+      }
+    }
+
+    out.setWindow(x0, p, x1, p);
+    out.beginData();
+    for (uint8_t x = x0; x <= x1; x++) out.sendByte(page[x]);
+    out.endTransm();
+  }
+
+  // Окно x0..x1 на страницах page0..page1: часть экрана, которую
+  // список описывает целиком, остальное в окне гаснет
+  template <class Out>
+  void renderWindow(Out& out, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1) {
+    for (uint8_t p = page0; p <= page1; p++) renderPage(out, p, x0, x1);
+  }
+};
+
+#endif // CANVAS_H
@@ -6,15 +6,16 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-#include <Arduino.h>
-#include <avr/wdt.h>
+#include "hal.h"
 
 // ============================================================================
 // ПИНЫ ПОДКЛЮЧЕНИЯ
 // ============================================================================
 
 #define DHT_PIN           6
-#define DHT_TYPE          DHT22
+
+#define SHT31_ADDRESS     0x44    // ADDR на GND, 0x45 - на VDD
+#define BME280_ADDRESS    0x76    // SDO на GND, 0x77 - на VDDIO
 
 #define OLED_ADDRESS      0x3C
 
@@ -42,6 +43,31 @@
 #define WATER_SENSOR_MIN         30
 #define WATER_SENSOR_MAX         900
 
+// ============================================================================
+// ДАТЧИК ТЕМПЕРАТУРЫ И ВЛАЖНОСТИ
+// ============================================================================
+
+// Датчики (sensor_driver.h), до SENSOR_MAX вместе. Опрашиваются по
+// очереди, за круг замеров - каждый по разу; в управление идет
+// среднее без выбросов. Можно задать при сборке: -DSENSOR_SHT31_ENABLED=1
+#ifndef SENSOR_DHT22_ENABLED
+  #define SENSOR_DHT22_ENABLED  true    // DHT22 на DHT_PIN
+#endif
+#ifndef DHT2_PIN
+  #define DHT2_PIN              0       // Второй DHT22 (порт D), 0 - нет
+#endif
+#ifndef SENSOR_SHT31_ENABLED
+  #define SENSOR_SHT31_ENABLED  false   // I2C, общая шина с дисплеем
+#endif
+#ifndef SENSOR_BME280_ENABLED
+  #define SENSOR_BME280_ENABLED false   // I2C, общая шина с дисплеем
+#endif
+
+#define SENSOR_MAX              4
+#define SENSOR_OUTLIER_HUM      50    // 0,1 %: дальше от медианы - выброс
+#define SENSOR_OUTLIER_TEMP     20    // 0,1 °C
+#define SENSOR_OUTLIER_MIN      3     // Медиана имеет смысл от трех датчиков
+
 // ============================================================================
 // НАСТРОЙКИ ПО УМОЛЧАНИЮ
 // ============================================================================
@@ -50,22 +76,90 @@
 #define DEFAULT_MAX_HUMIDITY    60
 #define DEFAULT_HYSTERESIS      5
 
-#define UPDATE_INTERVAL         2000
+// Период замера и управления. DHT22 - не чаще раза в 2 с, только
+// датчики на I2C позволяют 1 Гц
+#if SENSOR_DHT22_ENABLED || DHT2_PIN
+  #define UPDATE_INTERVAL       2000
+#else
+  #define UPDATE_INTERVAL       1000
+#endif
+
+// Адаптивный период (sampling.h): UPDATE_INTERVAL у порогов и при
+// быстром изменении, реже - пока влажность спокойно в полосе
+#ifndef ADAPTIVE_SAMPLING_ENABLED
+  #define ADAPTIVE_SAMPLING_ENABLED true
+#endif
+#define SAMPLE_INTERVAL_MAX     30000 // мс; не больше минуты - корзины истории
+#define SAMPLE_NEAR_BAND        30    // 0,1 %: ближе к порогу - часто
+#define SAMPLE_FAST_RATE        20    // 0,1 %/мин: быстрее - часто
+#define SAMPLE_RATE_WINDOW      20000 // мс, окно оценки скорости
+#define SAMPLE_HORIZON          8     // Замеров до порога при нынешней скорости
+
 #define AUTOSAVE_INTERVAL       300000
 #define MIN_RUN_TIME            30000
 #define MIN_PAUSE_TIME          60000
 
 #define MAX_SWITCHES_PER_HOUR   10
 
-#define TEMP_CALIBRATION        0.0
-#define HUM_CALIBRATION         0.0
+#define TEMP_CALIBRATION        0     // 0,1 °C
+#define HUM_CALIBRATION         0     // 0,1 %
+
+// ============================================================================
+// ДРАЙВЕРЫ ДАТЧИКОВ
+// ============================================================================
+
+#define DHT22_START_TIME        2     // мс, стартовый импульс (не меньше 1 мс)
+#define DHT22_TIMEOUT           10    // мс на прием 40 бит (~5 мс)
+#define DHT22_BIT_THRESHOLD     100   // мкс между спадами: ~77 = "0", ~120 = "1"
+#define DHT22_POLL_INTERVAL     1     // мс, опрос во время измерения
+#define DHT22_MIN_INTERVAL      2000  // мс между измерениями
+
+// SHT31 и BME280: одиночные замеры, готовность опрашивается
+#define SHT31_MEASURE_TIME      16    // мс, высокая точность (до 15,5 мс)
+#define SHT31_POLL_INTERVAL     2     // мс, опрос во время измерения
+#define SHT31_TIMEOUT           50    // мс от запуска до результата
+#define SHT31_MIN_INTERVAL      500   // мс между измерениями (самонагрев)
+
+#define BME280_MEASURE_TIME     8     // мс, T и RH x1 (до 7 мс)
+#define BME280_POLL_INTERVAL    2
+#define BME280_TIMEOUT          50    // С чтением калибровки в первый раз
+#define BME280_MIN_INTERVAL     500
+
+// Фильтр влажности для управления (filter.h). Экран показывает
+// замер как есть, увлажнитель включается по отфильтрованному
+#define FILTER_MEDIAN_SIZE      3     // Медиана из N замеров: 1 - без нее, не больше 7
+#define FILTER_SMOOTH_NONE      0
+#define FILTER_SMOOTH_EMA       1     // Экспоненциальное
+#define FILTER_SMOOTH_KALMAN    2
+#define FILTER_SMOOTH           FILTER_SMOOTH_EMA
+#define FILTER_EMA_SHIFT        2     // Вес нового замера 1/4
+#define FILTER_KALMAN_Q         1     // Шум процесса за замер, (0,1 %)^2
+#define FILTER_KALMAN_R         16    // Шум датчика, (0,1 %)^2: DHT22 - сигма 0,4 %
+
+// ============================================================================
+// ПЛАНИРОВЩИК ЗАДАЧ
+// ============================================================================
+
+#define SCHEDULER_MAX_TASKS     10
+#define ENCODER_POLL_INTERVAL   50    // События энкодера будят loop сразу
+#define DISPLAY_UPDATE_INTERVAL 500
+#define WATER_CHECK_INTERVAL    1000
+#define EEPROM_SAVE_INTERVAL    60000
+#define SERIAL_POLL_INTERVAL    50
+
+// ============================================================================
+// ЭНЕРГОСБЕРЕЖЕНИЕ
+// ============================================================================
+
+#define POWER_MAX_SLEEP         500     // мс, меньше таймаута watchdog (4 с)
+#define POWER_STATS_WINDOW      10000   // мс, окно расчета доли бодрствования
 
 // ============================================================================
 // ДЕТЕКТОР ОТКРЫТОГО ОКНА
 // ============================================================================
 
 #define WINDOW_DETECTOR_ENABLED true
-#define WINDOW_TEMP_DROP        2.0
+#define WINDOW_TEMP_DROP        20    // 0,1 °C
 #define WINDOW_CHECK_INTERVAL   30000
 #define WINDOW_TEMP_SAMPLES     3
 
@@ -76,6 +170,13 @@
 #define STATS_ENABLED           true
 #define STATS_HISTORY_SIZE      24
 
+// История влажности для графиков за 1, 6 и 24 ч: 2 байта на корзину
+#define HISTORY_ENABLED         true
+#define HISTORY_MINUTE_MS       60000UL
+#define HISTORY_MINUTES         60    // Минутные корзины, 1 ч
+#define HISTORY_PERIOD_MINUTES  20    // Суточная корзина, минут
+#define HISTORY_PERIODS         72    // Суточные корзины, 24 ч (144 байта)
+
 #define LEARNING_ENABLED        true
 #define LEARNING_MIN_DATA       24
 
@@ -93,20 +194,98 @@
 #define DIM_TIMEOUT_1           10000
 #define DIM_TIMEOUT_2           180000
 
+// Язык надписей на экране (lang.h). Можно задать при сборке: -DUI_LANGUAGE=1
+#define LANG_RU                 0
+#define LANG_EN                 1
+#ifndef UI_LANGUAGE
+  #define UI_LANGUAGE           LANG_RU
+#endif
+
+// Операций в кадре PageCanvas (canvas.h), 6 байт RAM каждая.
+// Самые длинные кадры - по 20 операций: экран памяти (заголовок, пять
+// строк и четыре модуля) и половина страницы диагностики (заголовок и
+// три строки, числа больше 32767 - по две операции). Переполнение
+// пишется в журнал, прогоны на ПК завершаются с кодом 4
+#define CANVAS_OPS              20
+
+// Очередь I2C (twi.h): страница кадра - окно 9 байт и данные 131 байт,
+// в очередь помещается одна страница, следующая собирается, пока
+// предыдущая уходит на шину. Запас сверх страницы не нужен: поля,
+// которым не хватило места, Display дорисует через DISPLAY_BUSY_RETRY
+#define TWI_QUEUE_SIZE          144
+#define OLED_CHUNK              128   // Байт данных в одной транзакции
+#define OLED_PAGE_COST          (9 + 3 + OLED_CHUNK)  // Место под страницу в очереди
+#define DISPLAY_BUSY_RETRY      5     // мс до повтора, пока кадр уходит на шину
+
 // ============================================================================
 // НАСТРОЙКИ МЕНЮ
 // ============================================================================
 
-#define MENU_ITEMS              8
 #define LONG_PRESS_TIME         2000
 #define ENCODER_FAST_THRESHOLD  50
 
+// ============================================================================
+// ЭНКОДЕР
+// ============================================================================
+
+#define ENCODER_QUEUE_SIZE      16    // Степень двойки
+#define ENCODER_DEBOUNCE_TIME   5     // мс
+#define ENCODER_DOUBLE_TIMEOUT  300   // мс между кликами двойного нажатия
+#define ENCODER_REVERSE         false
+// Переходов квадратуры на щелчок: 2 - полушаговый энкодер (TYPE2
+// GyverEncoder, покой на 00 и на 11), 4 - полношаговый (покой на 11)
+#define ENCODER_STEPS_PER_DETENT 2
+
+// ============================================================================
+// ДИАГНОСТИКА
+// ============================================================================
+
+// Профилировщик (profiler.h, команды 'd'/'r' и страница меню) и
+// время задач планировщика. На Nano по умолчанию выключен: ~240 байт
+// SRAM, которых стеку иначе не хватает. На ПК включается из CMakeLists.txt
+#ifndef PROFILER_ENABLED
+  #define PROFILER_ENABLED      false
+#endif
+#define PROFILER_BUCKETS        12
+#define DIAG_REFRESH_INTERVAL   1000
+
+// Монитор памяти (memory.h, команда 'm' и страница меню), ~6 байт SRAM
+#ifndef MEMORY_MONITOR_ENABLED
+  #define MEMORY_MONITOR_ENABLED true
+#endif
+#define MEMORY_CHECK_INTERVAL   10000 // мс между проверками запаса стека
+#define MEMORY_STACK_WARN       64    // Байт запаса, ниже - запись в журнал
+
+// Замер отрисовки экранов (bench.h, команда 'b'). На ПК включается
+// из CMakeLists.txt для display_bench
+#ifndef DISPLAY_BENCH_ENABLED
+  #define DISPLAY_BENCH_ENABLED false
+#endif
+#define DISPLAY_BENCH_REPEATS   10
+
+// ============================================================================
+// ЖУРНАЛ (Serial)
+// ============================================================================
+
+#define LOG_LEVEL_NONE          0
+#define LOG_LEVEL_ERROR         1
+#define LOG_LEVEL_WARN          2
+#define LOG_LEVEL_INFO          3
+#define LOG_LEVEL_DEBUG         4
+
+// Вызовы ниже этого уровня не попадают в прошивку
+#define LOG_LEVEL               LOG_LEVEL_INFO
+#define LOG_BUFFER_SIZE         64    // Степень двойки, не больше 256
+#define LOG_LINE_MAX            48    // Не больше LOG_BUFFER_SIZE
+#define LOG_TAG_MAX             5
+
 // ============================================================================
 // АДРЕСА EEPROM
 // ============================================================================
 
 #define EEPROM_MAGIC_ADDR          0
-#define EEPROM_MAGIC_VALUE         0xAE
+#define EEPROM_MAGIC_VALUE         0xAF
+#define EEPROM_MAGIC_FLOAT_CAL     0xAE  // Старый образ: калибровка во float
 #define EEPROM_MIN_HUM_ADDR        1
 #define EEPROM_MAX_HUM_ADDR        2
 #define EEPROM_HYSTERESIS_ADDR     3
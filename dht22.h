@@ -0,0 +1,149 @@
+/*
+ * НЕБЛОКИРУЮЩИЙ ДРАЙВЕР DHT22
+ * Стартовый импульс формируется по millis(), спады линии данных
+ * ловятся прерыванием PCINT, разбор битов - позже в poll().
+ * Прерывания на время обмена не запрещаются. Один из драйверов
+ * Sensor (sensor_driver.h). Датчиков может быть несколько на разных
+ * выводах порта D: Sensor опрашивает их по очереди, поэтому
+ * прерывание обслуживает только тот, что сейчас принимает биты.
+ */
+
+#ifndef DHT22_H
+#define DHT22_H
+
+#include "hal.h"
+#include "config.h"
+#include "sensor_driver.h"
+
+#if DHT_PIN > 7 || DHT2_PIN > 7
+  #error "DHT22 pins must be on port D (D0-D7): HAL_ISR_PIN_CHANGE covers port D only"
+#endif
+
+// Спад 0 - ответ датчика, спад 1 - начало первого бита, ..., спад 41 - конец 40-го бита
+#define DHT22_EDGES 42
+
+enum Dht22State {
+  DHT22_STATE_IDLE = 0,
+  DHT22_STATE_START = 1,    // Линия прижата к нулю хостом
+  DHT22_STATE_CAPTURE = 2   // Прием фронтов в прерывании
+};
+
+class Dht22 : public SensorDriver {
+private:
+  // Интервалы между спадами, мкс (насыщение на 255).
+  // [0] - ответ датчика (~160), [1..40] - биты (~77 = "0", ~120 = "1")
+  volatile uint8_t edgeDelta[DHT22_EDGES - 1];
+  volatile uint8_t edgeCount;
+  volatile unsigned long lastEdge;
+
+  uint8_t pin;
+  uint8_t state;
+  unsigned long stateTime;
+
+  // Датчик, чьи фронты сейчас ловит прерывание
+  static Dht22*& instance() {
+    static Dht22* inst = nullptr;
+    return inst;
+  }
+
+  uint8_t decode() {
+    uint8_t data[5] = {0, 0, 0, 0, 0};
+
+    for (uint8_t i = 0; i < 40; i++) {
+      data[i >> 3] <<= 1;
+      if (edgeDelta[i + 1] > DHT22_BIT_THRESHOLD) data[i >> 3] |= 1;
+    }
+
+    if ((uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4]) {
+      return SENSOR_ERROR_CHECKSUM;
+    }
+
+    humidity = ((int16_t)data[0] << 8) | data[1];
+    temperature = ((int16_t)(data[2] & 0x7F) << 8) | data[3];
+    if (data[2] & 0x80) temperature = -temperature;
+
+    return SENSOR_OK;
+  }
+
+public:
+  explicit Dht22(uint8_t dataPin)
+    : SensorDriver(DHT22_MIN_INTERVAL, DHT22_POLL_INTERVAL),
+      edgeCount(0), lastEdge(0), pin(dataPin), state(DHT22_STATE_IDLE), stateTime(0) {}
+
+  void begin() {
+    pinMode(pin, INPUT_PULLUP);
+    halPinChangeBegin(pin);
+  }
+
+  bool start() override {
+    if (state != DHT22_STATE_IDLE) return false;
+
+    digitalWrite(pin, LOW);
+    pinMode(pin, OUTPUT);
+    state = DHT22_STATE_START;
+    stateTime = millis();
+    return true;
+  }
+
+  uint8_t poll() override {
+    switch (state) {
+      case DHT22_STATE_START:
+        if (millis() - stateTime < DHT22_START_TIME) return SENSOR_BUSY;
+
+        // Прерывание включаем до отпускания линии: ответ придет через 20-40 мкс
+        edgeCount = 0;
+        lastEdge = micros();
+        instance() = this;
+        halPinChangeEnable(pin, true);
+        pinMode(pin, INPUT_PULLUP);
+        state = DHT22_STATE_CAPTURE;
+        stateTime = millis();
+        return SENSOR_BUSY;
+
+      case DHT22_STATE_CAPTURE:
+        if (edgeCount >= DHT22_EDGES) {
+          halPinChangeEnable(pin, false);
+          state = DHT22_STATE_IDLE;
+          return decode();
+        }
+        if (millis() - stateTime >= DHT22_TIMEOUT) {
+          halPinChangeEnable(pin, false);
+          state = DHT22_STATE_IDLE;
+          return SENSOR_ERROR_TIMEOUT;
+        }
+        return SENSOR_BUSY;
+    }
+    return SENSOR_BUSY;
+  }
+
+  bool isBusy() const { return state != DHT22_STATE_IDLE; }
+
+  // ==========================================================================
+  // ОБРАБОТЧИК ПРЕРЫВАНИЯ
+  // ==========================================================================
+
+  static void isrEdge() {
+    if (instance()) instance()->onEdge();
+  }
+
+  // Любая смена уровня на порту D. Интересны только спады на pin:
+  // минимальная длительность уровня 26 мкс, поэтому задержка входа
+  // в прерывание (энкодер, Timer0) не искажает считанный уровень
+  void onEdge() {
+    if (edgeCount >= DHT22_EDGES || digitalRead(pin) != LOW) return;
+
+    unsigned long now = micros();
+    if (edgeCount > 0) {
+      unsigned long delta = now - lastEdge;
+      edgeDelta[edgeCount - 1] = delta > 255 ? 255 : delta;
+    }
+    lastEdge = now;
+    edgeCount++;
+  }
+};
+
+HAL_ISR_PIN_CHANGE() {
+  Dht22::isrEdge();
+}
+
+#endif // DHT22_H
@@ -1,6 +1,7 @@
 /*
  * МОДУЛЬ ДИСПЛЕЯ OLED 128x64
- * Использует библиотеку GyverOLED (режим без буфера)
+ * GyverOLED (режим без буфера) - инициализация и шрифт, кадры идут
+ * через очередь I2C (twi.h)
  * Поддержка русского языка
  * v2.2 - исправление черного экрана
  */
@@ -8,12 +9,15 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
-#include <Arduino.h>
-#include <Wire.h>
+#include "hal.h"
 #include "config.h"
-
-// Подключаем GyverOLED напрямую из локальной библиотеки
-#include <GyverOLED.h>
+#include "history.h"
+#include "storage.h"
+#include "sensor.h"
+#include "canvas.h"
+#include "twi.h"
+#include "lang.h"
+#include "fixed.h"
 
 enum DisplayMode
 {
@@ -24,57 +28,557 @@ enum DisplayMode
 // Экраны внутри режима графика
 enum GraphScreen
 {
-  GRAPH_SCREEN_GRAPH = 0,
-  GRAPH_SCREEN_STATS = 1
+  GRAPH_SCREEN_GRAPH = 0,  // Живой график, точка на каждый замер
+  GRAPH_SCREEN_1H = 1,     // История: огибающая min/max
+  GRAPH_SCREEN_6H = 2,
+  GRAPH_SCREEN_24H = 3,
+  GRAPH_SCREEN_STATS = 4,
+  GRAPH_SCREEN_SENSORS = 5  // Показания каждого датчика
+};
+
+// Кривые живого графика, переключаются вращением влево
+enum GraphSeries
+{
+  SERIES_HUM = 0,
+  SERIES_BOTH = 1,   // Влажность и температура по своим шкалам
+  SERIES_TEMP = 2,
+  SERIES_COUNT = 3
 };
 
 #define GRAPH_POINTS 32
 
+// Цифры 3x5 для подписей шкал, столбцы сверху вниз; 10 - минус
+static const uint8_t smallGlyphs[11][3] PROGMEM = {
+  {0x1F, 0x11, 0x1F}, {0x12, 0x1F, 0x10}, {0x1D, 0x15, 0x17},
+  {0x15, 0x15, 0x1F}, {0x07, 0x04, 0x1F}, {0x17, 0x15, 0x1D},
+  {0x1F, 0x15, 0x1D}, {0x01, 0x01, 0x1F}, {0x1F, 0x15, 0x1F},
+  {0x17, 0x15, 0x1F}, {0x04, 0x04, 0x04}
+};
+
+// Область графика: страницы 3-7, строка уставки (страница 2) не задета
+#define GRAPH_TOP    24
+#define GRAPH_BOTTOM 63
+#define GRAPH_X0     2    // Столбец первой точки
+#define GRAPH_STEP   4    // Столбцов на точку: GRAPH_X0 + 31 * 4 = 126
+#define PLOT_TOP     (GRAPH_TOP + 2)     // Строки кривых
+#define PLOT_BOTTOM  (GRAPH_BOTTOM - 4)
+#define RUN_ROW      (GRAPH_BOTTOM - 2)  // Строка работы увлажнителя
+#define TEMP_GRAPH_OFFSET 40  // tempGraph: (T + 40) * 2, шаг 0.5 °C
+#define HISTORY_X0   2    // История - столбцы 2..125
+#define HISTORY_WIDTH 124
+#define HISTORY_LABEL_X 110  // Подпись вида истории, страница 2
+
+// Поля главного экрана: столбец начала текста
+#define FIELD_TEMP_X  0    // Страницы 0-1, масштаб 2
+#define FIELD_HUM_X   70   // Страницы 0-1, масштаб 2
+#define FIELD_SET_X   24   // Страница 2, после "SET:"
+#define FIELD_WATER_X 55   // Страница 2
+
+// Столбцы экрана датчиков, масштаб 1: имя, отметка выброса, значения
+#define SENS_MARK_X   44
+#define SENS_TEMP_X   50
+#define SENS_HUM_X    92
+
+// Поля экрана статистики, масштаб 1: после подписей
+#define STAT_TEMP_X   12   // Страница 2, после "T:"
+#define STAT_HUM_X    72   // Страница 2, после "H:"
+// Длина остальных подписей зависит от языка (lang.h)
+#define STAT_RUN_X    (uiStrChars(STR_HUMIDIFIER) * CHAR_WIDTH)  // Страница 3
+#define STAT_WORK_X   (uiStrChars(STR_WORK) * CHAR_WIDTH)        // Страница 4
+#define STAT_WATER_X  (uiStrChars(STR_WATER) * CHAR_WIDTH)       // Страница 5
+
+#define CHAR_WIDTH    6    // Символ 5 столбцов + промежуток, при масштабе 1
+
+// Показанные значения полей: особые случаи
+#define FIELD_NOT_SHOWN    -32768  // Поле еще не нарисовано
+#define FIELD_INVALID      -32767  // Значение вне диапазона, "--"
+#define WATER_SHOWN_ABSENT -1      // Нет датчика
+#define WATER_SHOWN_EMPTY  -2      // NO WATER!
+#define WATER_SHOWN_LOW    -3      // LOW
+
+typedef GyverOLED<SSD1306_128x64, OLED_NO_BUFFER, OLED_I2C> OledDriver;
+
+// Вывод в SSD1306 через очередь TWI: те же setWindow/beginData/
+// sendByte/endTransm, что у GyverOLED, но без ожидания шины.
+// Поток данных режется на транзакции по OLED_CHUNK байт - окно
+// дисплея продолжается с того же места. Очередь общая с датчиками
+// на I2C (sht3x.h, bme280.h), владелец - скетч
+class OledBus
+{
+private:
+  TwiQueue *queue;
+  OledDriver *font;
+  uint8_t chunk;  // Байт данных в открытой транзакции
+
+public:
+  OledBus() : queue(nullptr), font(nullptr), chunk(0) {}
+
+  // Очередь запускается здесь: до этого шиной пользуется GyverOLED
+  void begin(OledDriver *oled, TwiQueue *twi, unsigned long clock)
+  {
+    font = oled;
+    queue = twi;
+    queue->begin(clock);
+  }
+
+  uint8_t getFont(uint8_t code, uint8_t row) { return font->getFont(code, row); }
+
+  void command(uint8_t cmd, uint8_t value)
+  {
+    queue->beginTransmission(OLED_ADDRESS);
+    queue->write(0x00);
+    queue->write(cmd);
+    queue->write(value);
+    queue->endTransmission();
+  }
+
+  void setWindow(uint8_t x0, uint8_t page0, uint8_t x1, uint8_t page1)
+  {
+    queue->beginTransmission(OLED_ADDRESS);
+    queue->write(0x00);
+    queue->write(0x21);  // Столбцы
+    queue->write(x0);
+    queue->write(x1);
+    queue->write(0x22);  // Страницы
+    queue->write(page0);
+    queue->write(page1);
+    queue->endTransmission();
+  }
+
+  void beginData()
+  {
+    queue->beginTransmission(OLED_ADDRESS);
+    queue->write(0x40);
+    chunk = 0;
+  }
+
+  void sendByte(uint8_t b)
+  {
+    if (chunk >= OLED_CHUNK)
+    {
+      queue->endTransmission();
+      beginData();
+    }
+    queue->write(b);
+    chunk++;
+  }
+
+  void endTransm() { queue->endTransmission(); }
+
+  uint8_t space() const { return queue->space(); }
+  bool isBusy() const { return queue->isBusy(); }
+  void flush() { queue->flush(); }
+  uint8_t getErrors() const { return queue->getErrors(); }
+};
+
 class Display
 {
 private:
-  // OLED объект как член класса (предотвращает multiple definition)
-  GyverOLED<SSD1306_128x64, OLED_NO_BUFFER, OLED_I2C> oled;
-  
-  int cursorX, cursorY;
-  uint8_t textScale;
-  bool invert;
-
-  float lastTemp, lastHum;
-  uint8_t lastTargetHum;
-  bool lastRunning;
-  unsigned long lastWorkTime;
+  // OLED объект как член класса (предотвращает multiple definition).
+  // Нужен для инициализации и шрифта, кадры идут через bus
+  OledDriver oled;
+  OledBus bus;
+  // Кадры и поля собираются постранично и уходят в очередь по одной
+  // странице, пока в ней есть место: loop() не ждет шину
+  PageCanvas canvas;
+  uint8_t framePages;  // Маска страниц кадра, еще не отправленных
+
   bool lastSensorOK;
-  bool lastWaterLow;
   bool firstDraw;
-  int lastWaterValue;
-  bool lastWaterPresent;
+  bool fieldsPending;  // Поле или участок графика не влез в очередь
+
+  // Что сейчас на экране: значение поля и длина его текста в символах.
+  // Температура, влажность и вода общие для главного экрана и
+  // статистики - полная отрисовка любого из них сбрасывает все поля
+  int16_t shownTemp, shownHum, shownTarget, shownWater;
+  uint8_t tempChars, humChars, targetChars, waterChars;
+  int8_t shownRunning;          // Статистика: -1 - не нарисовано
+  unsigned long shownWorkMin;   // Статистика: время работы, минуты
+  uint8_t runChars, workChars;
+  bool graphDirty;  // Добавлена точка, график не перерисован
 
   uint8_t currentBrightness;
   DisplayMode currentMode;
-  uint8_t graphScreen; // 0 = график, 1 = статистика
+  uint8_t graphScreen; // GraphScreen
+  History* history;
+  uint16_t historyShown;  // History::getVersion() на экране
+  Storage* storage;
+  Sensor* sensor;
+  uint8_t sensorsShown;   // Sensor::getRounds() на экране
+  uint8_t sensorsPage;    // Следующая страница экрана датчиков
+
+  // Шкалы графика: влажность в %, температура в единицах tempGraph
+  uint8_t graphSeries;
+  uint8_t humLo, humHi;
+  uint8_t tempLo, tempHi;
+  uint8_t bandLo, bandHi;  // Уставки на экране
 
   uint8_t humGraph[GRAPH_POINTS];
+  uint8_t tempGraph[GRAPH_POINTS];
   uint32_t humState;
   uint8_t gIdx;
   bool gFull;
+  uint8_t graphDrawnIdx;  // gIdx на момент последней отрисовки графика
+
+  // Столбцы участка точки i. Участок 0 - столбцы 1..GRAPH_X0
+  static uint8_t segmentStart(uint8_t i)
+  {
+    return i == 0 ? 1 : GRAPH_X0 + (i - 1) * GRAPH_STEP + 1;
+  }
+
+  static uint8_t segmentEnd(uint8_t i) { return GRAPH_X0 + i * GRAPH_STEP; }
+
+  static uint8_t segmentOf(uint8_t x)
+  {
+    return (x - GRAPH_X0 + GRAPH_STEP - 1) / GRAPH_STEP;
+  }
+
+  // Строка графика для значения v при шкале lo..hi
+  static int16_t valueY(int16_t v, int16_t lo, int16_t hi)
+  {
+    v = constrain(v, lo, hi);
+    return PLOT_BOTTOM - (int32_t)(v - lo) * (PLOT_BOTTOM - PLOT_TOP) / (hi - lo);
+  }
+
+  int16_t humY(uint8_t hum) const { return valueY(hum, humLo, humHi); }
+  int16_t tempY(uint8_t t) const { return valueY(t, tempLo, tempHi); }
+
+  // Пределы шкалы: данные с запасом до кратного step, не уже minSpan
+  static void fitScale(uint8_t lo, uint8_t hi, uint8_t step, uint8_t minSpan,
+                       uint8_t limit, uint8_t &outLo, uint8_t &outHi)
+  {
+    int16_t l = lo > 0 ? (lo - 1) / step * step : 0;
+    int16_t h = (hi / step + 1) * step;
+    if (h > limit)
+      h = limit;
+    while (h - l < minSpan)
+    {
+      if (h + step <= limit)
+        h += step;
+      if (h - l < minSpan && l >= step)
+        l -= step;
+      if (l < step && h + step > limit)
+        break;
+    }
+    outLo = l;
+    outHi = h;
+  }
+
+  // Автомасштаб по видимым данным. true - шкала изменилась
+  bool updateScale()
+  {
+    uint8_t hLo = 255, hHi = 0, tLo = 255, tHi = 0;
+    if (isHistoryScreen())
+    {
+      uint8_t view = graphScreen - GRAPH_SCREEN_1H;
+      for (uint8_t p = 0; p < History::getViewSize(view); p++)
+      {
+        HistoryBucket b = history->getBucket(view, p);
+        if (History::isEmpty(b))
+          continue;
+        hLo = min(hLo, History::getMin(b));
+        hHi = max(hHi, History::getMax(b));
+      }
+    }
+    else
+    {
+      for (uint8_t i = 0; i < GRAPH_POINTS; i++)
+      {
+        if (!gFull && i >= gIdx)
+          break;
+        hLo = min(hLo, humGraph[i]);
+        hHi = max(hHi, humGraph[i]);
+        tLo = min(tLo, tempGraph[i]);
+        tHi = max(tHi, tempGraph[i]);
+      }
+    }
+    if (hLo > hHi)
+    {
+      hLo = 0;
+      hHi = 100;
+    }
+    if (tLo > tHi)
+    {
+      tLo = TEMP_GRAPH_OFFSET * 2;
+      tHi = tLo + 20;
+    }
+
+    uint8_t newHumLo, newHumHi, newTempLo, newTempHi;
+    fitScale(hLo, hHi, 5, 10, 100, newHumLo, newHumHi);
+    fitScale(tLo, tHi, 2, 8, 254, newTempLo, newTempHi);
+    bool changed = newHumLo != humLo || newHumHi != humHi ||
+                   newTempLo != tempLo || newTempHi != tempHi;
+    humLo = newHumLo;
+    humHi = newHumHi;
+    tempLo = newTempLo;
+    tempHi = newTempHi;
+    return changed;
+  }
+
+  // Уставки изменились с последней отрисовки графика
+  bool bandChanged() const
+  {
+    return storage && (storage->getMinHumidity() != bandLo ||
+                       storage->getMaxHumidity() != bandHi);
+  }
+
+  // Биты строк lo..hi в странице, начинающейся со строки top
+  static uint8_t spanBits(int16_t lo, int16_t hi, int16_t top)
+  {
+    uint8_t bits = 0;
+    for (int16_t y = max(lo, top); y <= min(hi, top + 7); y++)
+      bits |= 1 << (y - top);
+    return bits;
+  }
+
+  // Столбец x подписи шкалы: число мелким шрифтом 3x5 с левым верхним
+  // углом в (lx, ly). Подпись ложится поверх кривых
+  static uint8_t labelBits(uint8_t x, int16_t top, int16_t value, uint8_t lx, int16_t ly)
+  {
+    if (x < lx || ly >= top + 8 || ly + 5 <= top)
+      return 0;
+    char text[5];
+    uint8_t n = 0;
+    if (value < 0)
+    {
+      text[n++] = 10;
+      value = -value;
+    }
+    if (value >= 100)
+      text[n++] = value / 100 % 10;
+    if (value >= 10)
+      text[n++] = value / 10 % 10;
+    text[n++] = value % 10;
+
+    uint8_t col = x - lx;
+    if (col >= n * 4 || col % 4 == 3)
+      return 0;
+    uint8_t glyph = pgm_read_byte(&smallGlyphs[(uint8_t)text[col / 4]][col % 4]);
+    int16_t shift = ly - top;
+    return shift >= 0 ? glyph << shift : glyph >> -shift;
+  }
 
-  uint8_t lastChar;
+  // Ширина подписи в столбцах
+  static uint8_t labelWidth(int16_t value)
+  {
+    return intChars(value) * 4 - 1;
+  }
+
+  // Столбец истории: корзины, попавшие в столбец, сводятся в один
+  // размах min..max. Самая новая корзина - у правого края
+  uint8_t historyBits(uint8_t x, int16_t top) const
+  {
+    if (x < HISTORY_X0 || x >= HISTORY_X0 + HISTORY_WIDTH)
+      return 0;
+    uint8_t view = graphScreen - GRAPH_SCREEN_1H;
+    uint8_t size = History::getViewSize(view);
+    uint8_t c = x - HISTORY_X0;
+    uint8_t p0 = (uint16_t)c * size / HISTORY_WIDTH;
+    uint8_t p1 = (uint16_t)(c + 1) * size / HISTORY_WIDTH;
+    if (p1 <= p0)
+      p1 = p0 + 1;
+
+    uint8_t lo = 255, hi = 0, run = 0;
+    for (uint8_t p = p0; p < p1; p++)
+    {
+      HistoryBucket b = history->getBucket(view, size - 1 - p);
+      if (History::isEmpty(b))
+        continue;
+      lo = min(lo, History::getMin(b));
+      hi = max(hi, History::getMax(b));
+      run = max(run, History::getRun(b));
+    }
+    if (lo > hi)
+      return 0;
+
+    uint8_t bits = spanBits(humY(hi), humY(lo), top);
+    // Увлажнитель работал не меньше половины времени корзины
+    if (run >= 4)
+      bits |= spanBits(RUN_ROW, RUN_ROW, top);
+    return bits;
+  }
+
+  // Участок показан: точка есть и это не зазор за самой новой
+  bool segmentVisible(uint8_t i) const
+  {
+    if (gFull)
+      return i != gIdx;
+    return i < gIdx;
+  }
+
+  // Отрезок от предыдущей точки (строка y0) к точке i (строка y1):
+  // столбец x закрывает строки между значениями отрезка в x-1 и x
+  static uint8_t segmentBits(uint8_t x, uint8_t i, int16_t y0, int16_t y1, int16_t top)
+  {
+    if (i == 0)
+      return spanBits(y1, y1, top);
+    int16_t x0 = segmentEnd(i - 1);
+    int16_t a = y0 + (y1 - y0) * (x - 1 - x0) / GRAPH_STEP;
+    int16_t b = y0 + (y1 - y0) * (x - x0) / GRAPH_STEP;
+    return spanBits(min(a, b), max(a, b), top);
+  }
+
+  // Байт страницы page для столбца x области графика
+  uint8_t graphByte(uint8_t x, uint8_t page) const
+  {
+    if (x == 0 || x == 127)
+      return 0xFF;  // Боковые стороны рамки, GRAPH_TOP кратен 8
+
+    int16_t top = page * 8;
+    uint8_t bits = spanBits(GRAPH_TOP, GRAPH_TOP, top) |
+                   spanBits(GRAPH_BOTTOM, GRAPH_BOTTOM, top);
+
+    bool showHum = isHistoryScreen() || graphSeries != SERIES_TEMP;
+    bool showTemp = !isHistoryScreen() && graphSeries != SERIES_HUM;
+
+    // Полоса уставок - пунктир по шкале влажности
+    if (showHum && storage && (x & 3) == 0)
+    {
+      if (bandLo >= humLo && bandLo <= humHi)
+        bits |= spanBits(humY(bandLo), humY(bandLo), top);
+      if (bandHi >= humLo && bandHi <= humHi)
+        bits |= spanBits(humY(bandHi), humY(bandHi), top);
+    }
+
+    // Шкала влажности слева, температуры справа
+    if (showHum)
+    {
+      bits |= labelBits(x, top, humHi, 2, PLOT_TOP);
+      bits |= labelBits(x, top, humLo, 2, PLOT_BOTTOM - 4);
+    }
+    if (showTemp)
+    {
+      int16_t hi = tempHi / 2 - TEMP_GRAPH_OFFSET;
+      int16_t lo = tempLo / 2 - TEMP_GRAPH_OFFSET;
+      bits |= labelBits(x, top, hi, 126 - labelWidth(hi), PLOT_TOP);
+      bits |= labelBits(x, top, lo, 126 - labelWidth(lo), PLOT_BOTTOM - 4);
+    }
+
+    if (isHistoryScreen())
+      return bits | historyBits(x, top);
+
+    uint8_t i = segmentOf(x);
+    if (!segmentVisible(i))
+      return bits;
+
+    uint8_t prev = (i + GRAPH_POINTS - 1) % GRAPH_POINTS;
+    if (showHum)
+      bits |= segmentBits(x, i, humY(humGraph[prev]), humY(humGraph[i]), top);
+    // Температура - пунктиром через столбец
+    if (showTemp && (x & 1))
+      bits |= segmentBits(x, i, tempY(tempGraph[prev]), tempY(tempGraph[i]), top);
+
+    // Строка работы увлажнителя
+    if (humState & ((uint32_t)1 << i))
+      bits |= spanBits(RUN_ROW, RUN_ROW, top);
+    return bits;
+  }
+
+  // Столбцы x0..x1 на страницах графика одним окном
+  // Источник столбцов графика для кадра PageCanvas
+  static uint8_t graphColumn(const void *self, uint8_t x, uint8_t page)
+  {
+    return static_cast<const Display *>(self)->graphByte(x, page);
+  }
+
+  // Окно и данные в очереди, байт: n байт данных режутся по OLED_CHUNK
+  static uint16_t windowCost(uint16_t n)
+  {
+    return 9 + n + 3 * ((n + OLED_CHUNK - 1) / OLED_CHUNK);
+  }
+
+  // Частичное обновление не ждет шину: не влезло - дорисуется на
+  // следующем проходе (hasPendingFields). В пустую очередь уходит всё
+  bool fits(uint16_t cost)
+  {
+    if (cost <= bus.space() || !bus.isBusy())
+      return true;
+    fieldsPending = true;
+    return false;
+  }
+
+  bool drawGraphColumns(uint8_t x0, uint8_t x1)
+  {
+    uint8_t pages = (GRAPH_BOTTOM >> 3) - (GRAPH_TOP >> 3) + 1;
+    if (!fits(windowCost((uint16_t)(x1 - x0 + 1) * pages)))
+      return false;
+    finishFrame();
+    bus.setWindow(x0, GRAPH_TOP >> 3, x1, GRAPH_BOTTOM >> 3);
+    bus.beginData();
+    for (uint8_t page = GRAPH_TOP >> 3; page <= (GRAPH_BOTTOM >> 3); page++)
+    {
+      for (uint8_t x = x0; x <= x1; x++)
+        bus.sendByte(graphByte(x, page));
+    }
+    bus.endTransm();
+    return true;
+  }
+
+  // Отправка собранного кадра: страницы из маски pages уходят из
+  // pump(), остальные на экране не меняются
+  void sendFrame(uint8_t pages = 0xFF)
+  {
+    framePages = pages;
+    pump();
+  }
+
+  // Младшая из оставшихся страниц кадра - в очередь
+  void sendNextPage()
+  {
+    uint8_t p = 0;
+    while (!(framePages & (1 << p)))
+      p++;
+    framePages &= ~(1 << p);
+    canvas.renderPage(bus, p);
+  }
+
+  // Остаток кадра - с ожиданием места в очереди
+  void finishFrame()
+  {
+    while (framePages)
+      sendNextPage();
+  }
+
+  // Новый кадр: прежний дописывается в очередь до очистки списка
+  void beginFrame()
+  {
+    finishFrame();
+    canvas.clear();
+  }
+
+  // Поле главного экрана: окно шириной в новый или прежний текст,
+  // что длиннее. Остаток окна за текстом гаснет - хвост прежнего
+  // значения стирается тем же окном. false - не влезло в очередь,
+  // поле остается прежним
+  bool sendField(uint8_t x, uint8_t page, uint8_t scale, uint8_t chars, uint8_t oldChars)
+  {
+    uint8_t x1 = min(x + CHAR_WIDTH * scale * max(chars, oldChars) - 1, CANVAS_WIDTH - 1);
+    bool ok = fits(scale * windowCost(x1 - x + 1));
+    if (ok)
+      canvas.renderWindow(bus, x, x1, page, page + scale - 1);
+    canvas.clear();
+    return ok;
+  }
 
 public:
-  Display() : cursorX(0), cursorY(0), textScale(1), invert(false),
-              lastTemp(-999), lastHum(-999), lastTargetHum(0),
-              lastRunning(false), lastWorkTime(0), lastSensorOK(true),
-              lastWaterLow(false), firstDraw(true), lastWaterValue(0),
-              lastWaterPresent(false), currentBrightness(BRIGHTNESS_FULL),
+  Display() : framePages(0), lastSensorOK(true), firstDraw(true), fieldsPending(false),
+              shownTemp(FIELD_NOT_SHOWN), shownHum(FIELD_NOT_SHOWN),
+              shownTarget(FIELD_NOT_SHOWN), shownWater(FIELD_NOT_SHOWN),
+              tempChars(0), humChars(0), targetChars(0), waterChars(0),
+              shownRunning(-1), shownWorkMin(0), runChars(0), workChars(0),
+              graphDirty(false), currentBrightness(BRIGHTNESS_FULL),
               currentMode(MODE_DATA), graphScreen(GRAPH_SCREEN_GRAPH),
-              gIdx(0), gFull(false), humState(0),
-              lastChar(0)
+              history(nullptr), historyShown(0), storage(nullptr),
+              sensor(nullptr), sensorsShown(0), sensorsPage(CANVAS_PAGES),
+              graphSeries(SERIES_HUM), humLo(0), humHi(100),
+              tempLo(0), tempHi(20), bandLo(0), bandHi(0),
+              humState(0), gIdx(0), gFull(false), graphDrawnIdx(0)
   {
     memset(humGraph, 0, sizeof(humGraph));
+    memset(tempGraph, 0, sizeof(tempGraph));
   }
 
-  void begin()
+  void begin(TwiQueue *twi)
   {
     // Инициализация I2C шины
     Wire.begin();
@@ -90,16 +594,49 @@ public:
     oled.clear();
     oled.update();
     delay(50);
-    
+
+    // Дальше дисплей только через очередь
+    bus.begin(&oled, twi, 400000L);
     setBrightness(BRIGHTNESS_FULL);
   }
 
+  // Следующие страницы кадра в очередь, пока в ней есть место.
+  // Вызывается из loop() после каждого прохода планировщика
+  void pump()
+  {
+    while (framePages && bus.space() >= OLED_PAGE_COST)
+      sendNextPage();
+  }
+
+  // pump() есть что отправить: повод не засыпать
+  bool needsPump() const
+  {
+    return framePages && bus.space() >= OLED_PAGE_COST;
+  }
+
+  // Кадр еще не целиком на шине - новый рисовать рано
+  bool isBusy() const { return framePages || bus.isBusy(); }
+
+  // Прошлый drawMainScreen() дорисовал не все: повторить, когда
+  // очередь освободится
+  bool hasPendingFields() const { return fieldsPending; }
+
+  // Кадров, в которых список операций холста переполнился
+  uint16_t getCanvasOverflows() const { return canvas.getOverflows(); }
+
+  // Ждет, пока весь кадр дойдет до дисплея
+  void flush()
+  {
+    finishFrame();
+    bus.flush();
+  }
+
   void setBrightness(uint8_t brightness)
   {
     if (currentBrightness != brightness)
     {
       currentBrightness = brightness;
-      oled.setContrast(brightness);
+      bus.command(0x81, brightness);  // Контраст
     }
   }
 
@@ -112,50 +649,74 @@ public:
     firstDraw = true;
   }
 
-  // Переключение между экранами внутри режима графика
+  // Переключение между экранами внутри режима графика по кругу:
+  // живой график, история за 1/6/24 ч (если подключена), статистика,
+  // датчики (если подключены)
   void toggleGraphScreen()
   {
-    graphScreen = (graphScreen == GRAPH_SCREEN_GRAPH) ? GRAPH_SCREEN_STATS : GRAPH_SCREEN_GRAPH;
+    graphScreen++;
+    if (!history && isHistoryScreen())
+      graphScreen = GRAPH_SCREEN_STATS;
+    if (!sensor && graphScreen == GRAPH_SCREEN_SENSORS)
+      graphScreen = GRAPH_SCREEN_GRAPH;
+    if (graphScreen > GRAPH_SCREEN_SENSORS)
+      graphScreen = GRAPH_SCREEN_GRAPH;
     firstDraw = true;
   }
 
-  uint8_t getGraphScreen() const { return graphScreen; }
+  bool isHistoryScreen() const
+  {
+    return graphScreen >= GRAPH_SCREEN_1H && graphScreen <= GRAPH_SCREEN_24H;
+  }
 
-  DisplayMode getMode() const { return currentMode; }
+  void setHistory(History* h) { history = h; }
+  void setStorage(Storage* s) { storage = s; }
+  void setSensor(Sensor* s) { sensor = s; }
 
-  void invertText(bool inv)
+  // Кривые живого графика: влажность, обе, температура
+  void toggleGraphSeries()
   {
-    invert = inv;
-    oled.invertText(inv);
+    graphSeries = (graphSeries + 1) % SERIES_COUNT;
+    if (!isHistoryScreen())
+      firstDraw = true;
   }
 
-  void textMode(byte m) { oled.textMode(m); }
+  uint8_t getGraphScreen() const { return graphScreen; }
+
+  // Экран испорчен посторонней отрисовкой - следующий вызов
+  // drawMainScreen() перерисует его полностью
+  void invalidate() { firstDraw = true; }
+
+  DisplayMode getMode() const { return currentMode; }
+
+  void invertText(bool inv) { canvas.invertText(inv); }
 
   void showSplash()
   {
-    oled.clear();
-    cursorX = 0;
-    cursorY = 16;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(2);
-    oled.print("УВЛАЖНИТЕЛЬ");
-    oled.update();
+    beginFrame();
+    canvas.setCursor(0, 16);
+    canvas.setScale(2);
+    canvas.print(uiStr(STR_SPLASH));
+    sendFrame();
+    flush();
     delay(1000);
     
-    cursorX = 30;
-    cursorY = 48;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(1);
-    oled.print("v");
-    oled.print(FIRMWARE_VERSION);
-    oled.update();
+    canvas.setCursor(30, 48);
+    canvas.setScale(1);
+    canvas.print(F("v"));
+    canvas.print(FIRMWARE_VERSION);
+    sendFrame();
+    flush();
     delay(500);
   }
 
-  void addGraphPoint(float humidity, bool running)
+  // Значения в десятых долях (fixed.h)
+  void addGraphPoint(Deci humidity, bool running, Deci temperature)
   {
-    uint8_t val = (uint8_t)constrain(humidity, 0, 100);
+    uint8_t val = deciTrunc(constrain(humidity, 0, DECI(100)));
     humGraph[gIdx] = val;
+    int16_t t2 = (temperature + deciFromInt(TEMP_GRAPH_OFFSET)) / (DECI_SCALE / 2);
+    tempGraph[gIdx] = (uint8_t)constrain(t2, 0, 254);
     if (running)
       humState |= ((uint32_t)1 << gIdx);
     else
@@ -166,484 +727,717 @@ public:
       gIdx = 0;
       gFull = true;
     }
+    graphDirty = true;
+  }
+
+  // Что замер отрисовки (bench.h) меняет на экране: режим, страница
+  // графика и слот, который затрет тестовая точка
+  struct BenchState {
+    DisplayMode mode;
+    uint8_t graphScreen;
+    uint8_t hum, temp;
+    bool running;
+    uint8_t idx, drawnIdx;
+    bool full, dirty;
+  };
+
+  BenchState saveBenchState() const
+  {
+    BenchState st;
+    st.mode = currentMode;
+    st.graphScreen = graphScreen;
+    st.hum = humGraph[gIdx];
+    st.temp = tempGraph[gIdx];
+    st.running = (humState & ((uint32_t)1 << gIdx)) != 0;
+    st.idx = gIdx;
+    st.drawnIdx = graphDrawnIdx;
+    st.full = gFull;
+    st.dirty = graphDirty;
+    return st;
+  }
+
+  // Экран перерисовывается целиком (invalidate)
+  void restoreBenchState(const BenchState& st)
+  {
+    currentMode = st.mode;
+    graphScreen = st.graphScreen;
+    gIdx = st.idx;
+    humGraph[gIdx] = st.hum;
+    tempGraph[gIdx] = st.temp;
+    if (st.running)
+      humState |= ((uint32_t)1 << gIdx);
+    else
+      humState &= ~((uint32_t)1 << gIdx);
+    graphDrawnIdx = st.drawnIdx;
+    gFull = st.full;
+    graphDirty = st.dirty;
+    firstDraw = true;
+  }
+
+  // Число символов в десятичной записи
+  static uint8_t intChars(long v)
+  {
+    uint8_t n = v < 0 ? 2 : 1;
+    unsigned long u = v < 0 ? -(unsigned long)v : v;
+    while (u >= 10)
+    {
+      u /= 10;
+      n++;
+    }
+    return n;
+  }
+
+  // Строка из lang.h, возвращает длину в символах
+  uint8_t printStr(uint8_t id)
+  {
+    canvas.print(uiStr(id));
+    return uiStrChars(id);
+  }
+
+  // Число и единица измерения, FIELD_INVALID - "--". Возвращает длину
+  uint8_t printValue(uint8_t x, uint8_t page, uint8_t scale, int16_t value,
+                     const __FlashStringHelper *unit)
+  {
+    canvas.setCursor(x, page);
+    canvas.setScale(scale);
+    uint8_t chars;
+    if (value == FIELD_INVALID)
+    {
+      canvas.print(F("--"));
+      chars = 2;
+    }
+    else
+    {
+      canvas.print(value);
+      chars = intChars(value);
+    }
+    canvas.print(unit);
+    return chars + strlen_P(reinterpret_cast<const char*>(unit));
   }
 
   void dot(int x, int y, byte fill = 1)
   {
-    oled.dot(x, y, fill);
+    canvas.dot(x, y, fill);
   }
 
   void drawLine(int x0, int y0, int x1, int y1, byte fill = 1)
   {
-    oled.line(x0, y0, x1, y1, fill);
+    canvas.line(x0, y0, x1, y1, fill);
   }
 
   void line(int x0, int y0, int x1, int y1, byte fill = 1)
   {
-    oled.line(x0, y0, x1, y1, fill);
+    canvas.line(x0, y0, x1, y1, fill);
   }
 
   void fastLineH(int y, int x0, int x1, byte fill = 1)
   {
-    oled.fastLineH(y, x0, x1, fill);
+    canvas.fastLineH(y, x0, x1, fill);
   }
 
   void fastLineV(int x, int y0, int y1, byte fill = 1)
   {
-    oled.fastLineV(x, y0, y1, fill);
+    canvas.fastLineV(x, y0, y1, fill);
   }
 
+  // График рисуется "бегущим курсором": у каждой точки свой участок
+  // из GRAPH_STEP столбцов, новая точка ложится на место самой старой,
+  // а следующий за ней участок остается пустым и отделяет новое от
+  // старого. Поэтому новая точка стоит двух участков, а не всего
+  // графика. Байты столбцов вычисляются из humGraph сразу целиком,
+  // вместе с рамкой и строкой работы увлажнителя, и идут одним
+  // потоком - без точек, затирающих соседние пиксели страницы
+
+  // Шкала, уставки и отметки о том, что сейчас будет на экране
+  void prepareGraph()
+  {
+    updateScale();
+    if (storage)
+    {
+      bandLo = storage->getMinHumidity();
+      bandHi = storage->getMaxHumidity();
+    }
+    graphDirty = false;
+    graphDrawnIdx = gIdx;
+    if (history)
+      historyShown = history->getVersion();
+  }
+
+  // Вся область графика: рамка и все участки (или история)
   void drawGraph()
   {
-    line(0, 20, 127, 20);
-    line(0, 63, 127, 63);
-    line(0, 20, 0, 63);
-    line(127, 20, 127, 63);
+    prepareGraph();
+    beginFrame();
+    canvas.columns(0, 127, GRAPH_TOP >> 3, graphColumn, this);
+    sendFrame((uint8_t)(0xFF << (GRAPH_TOP >> 3)));  // Страницы графика до конца экрана
+  }
 
-    uint8_t cnt = gFull ? GRAPH_POINTS : gIdx;
-    if (cnt < 2)
-      return;
+  // Только участки, изменившиеся после прошлой отрисовки:
+  // новые точки и пустой участок за последней из них
+  void updateGraph()
+  {
+    uint8_t i = graphDrawnIdx;
+    for (;;)
+    {
+      if (!drawGraphColumns(segmentStart(i), segmentEnd(i)))
+      {
+        graphDrawnIdx = i;
+        return;
+      }
+      if (i == gIdx)
+        break;
+      i = (i + 1) % GRAPH_POINTS;
+    }
+    graphDrawnIdx = gIdx;
+    graphDirty = false;
+  }
 
-    int16_t prevX = -1, prevY = -1;
+  // Все поля экрана нужно нарисовать заново: экран чистый
+  void resetFields()
+  {
+    shownTemp = shownHum = shownTarget = shownWater = FIELD_NOT_SHOWN;
+    tempChars = humChars = targetChars = waterChars = 0;
+    shownRunning = -1;
+    runChars = workChars = 0;
+  }
 
-    for (uint8_t i = 0; i < cnt; i++)
-    {
-      uint8_t idx = gFull ? ((gIdx + i) % GRAPH_POINTS) : i;
-      uint8_t v = humGraph[idx];
+  // Экран статистики целиком
+  void drawStatsScreen(Deci temp, Deci hum, bool running, unsigned long workTime,
+                       bool waterLow, bool waterSensorPresent, uint8_t waterPercent)
+  {
+    beginFrame();
+    resetFields();
+    
+    // Заголовок
+    canvas.setCursor(30, 0);
+    canvas.setScale(1);
+    canvas.print(uiStr(STR_STATS_TITLE));
+    line(0, 10, 127, 10);
+
+    // Подписи, значения рисует updateStatsFields()
+    canvas.setCursor(0, 2);
+    canvas.print(F("T:"));
+    canvas.setCursor(60, 2);
+    canvas.print(F("H:"));
+    canvas.setCursor(0, 3);
+    canvas.print(uiStr(STR_HUMIDIFIER));
+    canvas.setCursor(0, 4);
+    canvas.print(uiStr(STR_WORK));
+    canvas.setCursor(0, 5);
+    canvas.print(uiStr(STR_WATER));
+
+    // Подсказка
+    canvas.setCursor(0, 7);
+    canvas.print(uiStr(STR_HINT_SELECT));
+
+    updateStatsFields(false, temp, hum, running, workTime,
+                      waterLow, waterSensorPresent, waterPercent);
+    sendFrame();
+  }
 
-      uint8_t px = 126 - (uint16_t)(cnt - 1 - i) * 124 / (cnt - 1);
-      uint8_t py = 61 - (uint16_t)v * 40 / 100;
-      py = constrain(py, 22, 61);
+  // Поля статистики, у которых изменилось отображаемое значение:
+  // целые градусы и проценты, состояние, минуты работы, вода.
+  // partial - как в updateDataFields()
+  void updateStatsFields(bool partial, Deci temp, Deci hum, bool running,
+                         unsigned long workTime, bool waterLow,
+                         bool waterSensorPresent, uint8_t waterPercent)
+  {
+    if (partial)
+      beginFrame();
+
+    int16_t t = (temp >= DECI(-40) && temp <= DECI(80)) ? deciTrunc(temp) : FIELD_INVALID;
+    if (t != shownTemp) {
+      uint8_t chars = printValue(STAT_TEMP_X, 2, 1, t, F("C"));
+      if (!partial || sendField(STAT_TEMP_X, 2, 1, chars, tempChars)) {
+        shownTemp = t;
+        tempChars = chars;
+      }
+    }
 
-      if (prevX >= 0)
-        line(prevX, prevY, px, py);
-      dot(px, py);
+    int16_t h = (hum >= 0 && hum <= DECI(100)) ? deciTrunc(hum) : FIELD_INVALID;
+    if (h != shownHum) {
+      uint8_t chars = printValue(STAT_HUM_X, 2, 1, h, F("%"));
+      if (!partial || sendField(STAT_HUM_X, 2, 1, chars, humChars)) {
+        shownHum = h;
+        humChars = chars;
+      }
+    }
 
-      if (humState & ((uint32_t)1 << idx))
-        dot(px, 61);
+    if (running != shownRunning) {
+      canvas.setCursor(STAT_RUN_X, 3);
+      canvas.setScale(1);
+      uint8_t chars = printStr(running ? STR_ON : STR_OFF);
+      if (!partial || sendField(STAT_RUN_X, 3, 1, chars, runChars)) {
+        shownRunning = running;
+        runChars = chars;
+      }
+    }
 
-      prevX = px;
-      prevY = py;
+    unsigned long minutes = workTime / 60;
+    if (workChars == 0 || minutes != shownWorkMin) {
+      canvas.setCursor(STAT_WORK_X, 4);
+      canvas.setScale(1);
+      uint8_t chars = 0;
+      if (minutes >= 60) {
+        canvas.print(minutes / 60);
+        chars = intChars(minutes / 60) + printStr(STR_HOURS);
+      }
+      canvas.print(minutes % 60);
+      chars += intChars(minutes % 60) + printStr(STR_MINUTES);
+      if (!partial || sendField(STAT_WORK_X, 4, 1, chars, workChars)) {
+        shownWorkMin = minutes;
+        workChars = chars;
+      }
+    }
+
+    int16_t w;
+    if (!waterSensorPresent) w = WATER_SHOWN_ABSENT;
+    else if (waterLow) w = WATER_SHOWN_EMPTY;
+    else w = waterPercent;
+    if (w != shownWater) {
+      uint8_t chars;
+      canvas.setCursor(STAT_WATER_X, 5);
+      canvas.setScale(1);
+      if (w == WATER_SHOWN_ABSENT) chars = printStr(STR_NONE);
+      else if (w == WATER_SHOWN_EMPTY) chars = printStr(STR_WATER_LOW);
+      else {
+        canvas.print(waterPercent);
+        canvas.print(F("%"));
+        chars = intChars(waterPercent) + 1;
+      }
+      if (!partial || sendField(STAT_WATER_X, 5, 1, chars, waterChars)) {
+        shownWater = w;
+        waterChars = chars;
+      }
     }
   }
 
-  // Экран статистики
-  void drawStatsScreen(float temp, float hum, bool running, unsigned long workTime,
-                       bool waterLow, bool waterSensorPresent, uint8_t waterPercent)
+  // Температура и влажность с десятыми в столбцах экрана датчиков
+  void printSensorValues(uint8_t page, Deci temp, Deci hum)
   {
-    oled.clear();
-    
-    // Заголовок
-    cursorX = 30;
-    cursorY = 0;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(1);
-    oled.print("СТАТИСТИКА");
-    line(0, 1, 127, 1);
-
-    // Температура
-    cursorX = 0;
-    cursorY = 2;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("T:");
-    if (temp >= -40 && temp <= 80)
-      oled.print((int)temp);
-    else
-      oled.print("--");
-    oled.print("C");
-
-    // Влажность
-    cursorX = 60;
-    cursorY = 2;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("H:");
-    if (hum >= 0 && hum <= 100)
-      oled.print((int)hum);
-    else
-      oled.print("--");
-    oled.print("%");
-
-    // Статус увлажнителя
-    cursorX = 0;
-    cursorY = 3;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("Увлажнитель:");
-    if (running)
-      oled.print("ВКЛ");
-    else
-      oled.print("ВЫКЛ");
-
-    // Время работы
-    cursorX = 0;
-    cursorY = 4;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("Работа:");
-    if (workTime >= 3600) {
-      oled.print(workTime / 3600);
-      oled.print("ч");
-    }
-    oled.print((workTime % 3600) / 60);
-    oled.print("м");
-
-    // Уровень воды
-    cursorX = 0;
-    cursorY = 5;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("Вода:");
-    if (!waterSensorPresent)
-      oled.print("НЕТ");
-    else if (waterLow)
-      oled.print("НИЗКО!");
-    else {
-      oled.print(waterPercent);
-      oled.print("%");
+    canvas.setCursor(SENS_TEMP_X, page);
+    deciPrint(canvas, temp);
+    canvas.print(F("C"));
+    canvas.setCursor(SENS_HUM_X, page);
+    deciPrint(canvas, hum);
+    canvas.print(F("%"));
+  }
+
+  // Строка экрана датчиков на странице page: заголовок (страницы 0-1),
+  // датчик page - 2 (последний замер без калибровки, "!" - выброс, не
+  // вошел в среднее) или сводное значение комнаты с калибровкой (7)
+  void addSensorsPage(uint8_t page, Deci temp, Deci hum, bool sensorOK)
+  {
+    canvas.setScale(1);
+    if (page < 2)
+    {
+      canvas.setCursor(30, 0);
+      canvas.print(uiStr(STR_SENSORS_TITLE));
+      line(0, 10, 127, 10);
+      return;
+    }
+    if (page == 7)
+    {
+      canvas.setCursor(0, 7);
+      canvas.print(uiStr(STR_ROOM));
+      if (sensorOK)
+        printSensorValues(7, temp, hum);
+      else
+      {
+        canvas.setCursor(SENS_TEMP_X, 7);
+        canvas.print(F("--"));
+      }
+      return;
     }
 
-    // Подсказка
-    cursorX = 0;
-    cursorY = 7;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("Поворот-выбор");
+    uint8_t i = page - 2;
+    if (i >= sensor->getCount())
+      return;
+    uint8_t health = sensor->getSensorHealth(i);
+    canvas.setCursor(0, page);
+    canvas.print(sensor->getName(i));
+    if (health == SENSOR_HEALTH_ERROR)
+    {
+      canvas.setCursor(SENS_TEMP_X, page);
+      canvas.print(uiStr(STR_ERROR));
+      canvas.print(F(" "));
+      canvas.print(sensor->getSensorErrors(i));
+      return;
+    }
+    if (health == SENSOR_HEALTH_NONE)
+    {
+      canvas.setCursor(SENS_TEMP_X, page);
+      canvas.print(F("--"));
+      return;
+    }
+    if (health == SENSOR_HEALTH_OUTLIER)
+    {
+      canvas.setCursor(SENS_MARK_X, page);
+      canvas.print(F("!"));
+    }
+    printSensorValues(page, sensor->getSensorTemperature(i),
+                      sensor->getSensorHumidity(i));
+  }
 
-    oled.update();
+  // Экран датчиков по странице за проход: строка датчика - около 10
+  // операций холста, и четыре датчика с комнатой в один список не
+  // помещаются. Страница, не влезшая в очередь, ждет следующего
+  // прохода (hasPendingFields). restart - с заголовка. true - экран
+  // дорисован
+  bool drawSensorsScreen(Deci temp, Deci hum, bool sensorOK, bool restart)
+  {
+    if (restart)
+    {
+      finishFrame();
+      resetFields();
+      sensorsPage = 0;
+      sensorsShown = sensor->getRounds();
+    }
+    while (sensorsPage < CANVAS_PAGES)
+    {
+      if (!fits(OLED_PAGE_COST))
+        return false;
+      canvas.clear();
+      addSensorsPage(sensorsPage, temp, hum, sensorOK);
+      canvas.renderPage(bus, sensorsPage);
+      sensorsPage++;
+    }
+    canvas.clear();
+    return true;
   }
 
-  void drawMainScreen(float temp, float hum, uint8_t targetHum,
+  void drawMainScreen(Deci temp, Deci hum, uint8_t targetHum,
                       bool running, unsigned long workTime, bool sensorOK,
                       bool waterLow, bool windowOpen,
                       bool waterSensorPresent, uint8_t waterPercent,
                       int waterRawValue)
   {
-    // Проверяем, нужно ли перерисовать
-    bool needRedraw = firstDraw;
-    
-    if (currentMode == MODE_GRAPH && graphScreen == GRAPH_SCREEN_STATS) {
-      // Для экрана статистики - всегда перерисовываем
-      needRedraw = true;
-    }
-    
-    if (sensorOK != lastSensorOK) needRedraw = true;
-    if (waterLow != lastWaterLow) needRedraw = true;
-    if (fabs(temp - lastTemp) >= 0.5) needRedraw = true;
-    if (fabs(hum - lastHum) >= 1) needRedraw = true;
-    if (targetHum != lastTargetHum) needRedraw = true;
-    if (running != lastRunning) needRedraw = true;
-
-    if (!needRedraw && !firstDraw) return;
-
-    // Если режим графика и экран статистики - рисуем статистику
-    if (currentMode == MODE_GRAPH && graphScreen == GRAPH_SCREEN_STATS) {
-      drawStatsScreen(temp, hum, running, workTime, waterLow, waterSensorPresent, waterPercent);
-    } else {
-      // Иначе рисуем основной экран или график
+    fieldsPending = false;
+    if (currentMode == MODE_GRAPH && graphScreen == GRAPH_SCREEN_SENSORS) {
+      // Заново - только после нового круга опроса, иначе остаток
+      // страниц прошлого прохода
+      if (firstDraw || sensor->getRounds() != sensorsShown)
+        drawSensorsScreen(temp, hum, sensorOK, true);
+      else if (sensorsPage < CANVAS_PAGES)
+        drawSensorsScreen(temp, hum, sensorOK, false);
+    } else if (currentMode == MODE_GRAPH && graphScreen == GRAPH_SCREEN_STATS) {
+      // Статистика, как и главный экран, - только изменившиеся поля
+      if (firstDraw)
+        drawStatsScreen(temp, hum, running, workTime, waterLow, waterSensorPresent, waterPercent);
+      else
+        updateStatsFields(true, temp, hum, running, workTime,
+                          waterLow, waterSensorPresent, waterPercent);
+    } else if (firstDraw || sensorOK != lastSensorOK) {
       drawDataScreen(temp, hum, targetHum, running, workTime, sensorOK,
                      waterLow, waterSensorPresent, waterPercent, waterRawValue);
+    } else if (sensorOK) {
+      // Только изменившиеся поля и новый участок графика
+      updateDataFields(true, temp, hum, targetHum, waterLow,
+                       waterSensorPresent, waterPercent);
+      if (currentMode == MODE_GRAPH) {
+        // Новая шкала или уставки - график целиком. История
+        // к тому же сдвигается целиком раз в минуту
+        bool full = updateScale() || bandChanged();
+        if (isHistoryScreen() && history->getVersion() != historyShown)
+          full = true;
+        if (full)
+          drawGraph();
+        else if (!isHistoryScreen() && graphDirty)
+          updateGraph();
+      }
     }
 
-    lastTemp = temp;
-    lastHum = hum;
-    lastTargetHum = targetHum;
-    lastRunning = running;
-    lastWorkTime = workTime;
     lastSensorOK = sensorOK;
-    lastWaterLow = waterLow;
-    lastWaterPresent = waterSensorPresent;
-    lastWaterValue = waterRawValue;
     firstDraw = false;
   }
 
-  // Основной экран с данными и графиком
-  void drawDataScreen(float temp, float hum, uint8_t targetHum,
+  // Основной экран с данными и графиком, целиком
+  void drawDataScreen(Deci temp, Deci hum, uint8_t targetHum,
                       bool running, unsigned long workTime, bool sensorOK,
                       bool waterLow, bool waterSensorPresent, uint8_t waterPercent,
                       int waterRawValue)
   {
-    oled.clear();
+    beginFrame();
 
     if (!sensorOK)
     {
-      oled.setCursor(15, 3);
-      oled.setScale(2);
-      oled.print("ОШИБКА");
-      oled.setCursor(20, 6);
-      oled.setScale(1);
-      oled.print("DHT22");
+      canvas.setCursor(15, 3);
+      canvas.setScale(2);
+      canvas.print(uiStr(STR_ERROR));
+      canvas.setCursor(20, 6);
+      canvas.setScale(1);
+      if (sensor && sensor->getCount() == 1)
+        canvas.print(sensor->getName(0));
+      else
+        canvas.print(uiStr(STR_SENSORS_TITLE));
       lastSensorOK = sensorOK;
       firstDraw = false;
-      oled.update();
+      sendFrame();
       return;
     }
 
-    cursorX = 0;
-    cursorY = 0;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(2);
-    if (temp >= -40 && temp <= 80)
-      oled.print((int)temp);
-    else
-      oled.print("--");
-    oled.print("C");
-
-    cursorX = 70;
-    cursorY = 0;
-    oled.setCursor(cursorX, cursorY);
-    if (hum >= 0 && hum <= 100)
-      oled.print((int)hum);
-    else
-      oled.print("--");
-    oled.print("%");
-
-    cursorX = 0;
-    cursorY = 2;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(1);
-    oled.print("SET:");
-    oled.print(targetHum);
-    oled.print("%");
-
-    cursorX = 55;
-    cursorY = 2;
-    oled.setCursor(cursorX, cursorY);
-    if (!waterSensorPresent)
-      oled.print("--");
-    else if (waterLow)
-      oled.print("NO WATER!");
-    else if (waterPercent < 30)
-      oled.print("LOW");
-    else
-    {
-      oled.print("OK");
-      oled.print(waterPercent);
-      oled.print("%");
-    }
+    // Экран чистый - поля рисуются заново
+    resetFields();
+
+    canvas.setCursor(0, 2);
+    canvas.setScale(1);
+    canvas.print(F("SET:"));
+
+    updateDataFields(false, temp, hum, targetHum, waterLow, waterSensorPresent, waterPercent);
 
     if (currentMode == MODE_GRAPH) {
-      drawGraph();
+      canvas.setCursor(HISTORY_LABEL_X, 2);
+      if (isHistoryScreen())
+        canvas.print(History::getViewName(graphScreen - GRAPH_SCREEN_1H));
+      else if (graphSeries == SERIES_HUM)
+        canvas.print(uiStr(STR_SERIES_HUM));
+      else if (graphSeries == SERIES_BOTH)
+        canvas.print(uiStr(STR_SERIES_BOTH));
+      else
+        canvas.print(uiStr(STR_SERIES_TEMP));
+      prepareGraph();
+      canvas.columns(0, 127, GRAPH_TOP >> 3, graphColumn, this);
     }
 
-    oled.update();
+    sendFrame();
+  }
+
+  // Перерисовывает поля главного экрана, у которых изменилось
+  // отображаемое значение. partial - поля уходят на экран сразу,
+  // каждое своим окном; иначе только записываются в собираемый кадр
+  void updateDataFields(bool partial, Deci temp, Deci hum, uint8_t targetHum,
+                        bool waterLow, bool waterSensorPresent, uint8_t waterPercent)
+  {
+    if (partial)
+      beginFrame();
+
+    int16_t t = (temp >= DECI(-40) && temp <= DECI(80)) ? deciTrunc(temp) : FIELD_INVALID;
+    if (t != shownTemp) {
+      uint8_t chars = printValue(FIELD_TEMP_X, 0, 2, t, F("C"));
+      if (!partial || sendField(FIELD_TEMP_X, 0, 2, chars, tempChars)) {
+        shownTemp = t;
+        tempChars = chars;
+      }
+    }
+
+    int16_t h = (hum >= 0 && hum <= DECI(100)) ? deciTrunc(hum) : FIELD_INVALID;
+    if (h != shownHum) {
+      uint8_t chars = printValue(FIELD_HUM_X, 0, 2, h, F("%"));
+      if (!partial || sendField(FIELD_HUM_X, 0, 2, chars, humChars)) {
+        shownHum = h;
+        humChars = chars;
+      }
+    }
+
+    if (targetHum != shownTarget) {
+      uint8_t chars = printValue(FIELD_SET_X, 2, 1, targetHum, F("%"));
+      if (!partial || sendField(FIELD_SET_X, 2, 1, chars, targetChars)) {
+        shownTarget = targetHum;
+        targetChars = chars;
+      }
+    }
+
+    int16_t w;
+    if (!waterSensorPresent) w = WATER_SHOWN_ABSENT;
+    else if (waterLow) w = WATER_SHOWN_EMPTY;
+    else if (waterPercent < 30) w = WATER_SHOWN_LOW;
+    else w = waterPercent;
+    if (w != shownWater) {
+      uint8_t chars;
+      canvas.setCursor(FIELD_WATER_X, 2);
+      canvas.setScale(1);
+      if (w == WATER_SHOWN_ABSENT) { canvas.print(F("--")); chars = 2; }
+      else if (w == WATER_SHOWN_EMPTY) chars = printStr(STR_NO_WATER);
+      else if (w == WATER_SHOWN_LOW) chars = printStr(STR_LOW);
+      else {
+        chars = printStr(STR_OK) + intChars(waterPercent) + 1;
+        canvas.print(waterPercent);
+        canvas.print(F("%"));
+      }
+      if (!partial || sendField(FIELD_WATER_X, 2, 1, chars, waterChars)) {
+        shownWater = w;
+        waterChars = chars;
+      }
+    }
   }
 
   void drawAboutScreen(unsigned long workTime, uint8_t switchCount,
                        unsigned long totalSwitches, bool waterSensorPresent,
                        uint16_t waterThreshold, int waterRawValue)
   {
-    oled.clear();
-    cursorX = 20;
-    cursorY = 0;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(1);
-    oled.print("О СИСТЕМЕ");
-    line(0, 1, 127, 1);
-
-    cursorX = 0;
-    cursorY = 2;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("v");
-    oled.print(FIRMWARE_VERSION);
-    cursorX = 70;
-    cursorY = 2;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("kelll31");
-
-    cursorX = 0;
-    cursorY = 3;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("Работа:");
-    oled.print(workTime / 3600);
-    oled.print("ч");
-    oled.print((workTime % 3600) / 60);
-    oled.print("м");
-
-    cursorX = 0;
-    cursorY = 4;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("Перекл:");
-    oled.print(switchCount);
-    oled.print("/ч");
+    beginFrame();
+    canvas.setCursor(20, 0);
+    canvas.setScale(1);
+    canvas.print(uiStr(STR_ABOUT_TITLE));
+    line(0, 10, 127, 10);
+
+    canvas.setCursor(0, 2);
+    canvas.print(F("v"));
+    canvas.print(FIRMWARE_VERSION);
+    canvas.setCursor(70, 2);
+    canvas.print(F("kelll31"));
+
+    canvas.setCursor(0, 3);
+    canvas.print(uiStr(STR_WORK));
+    canvas.print(workTime / 3600);
+    canvas.print(uiStr(STR_HOURS));
+    canvas.print((workTime % 3600) / 60);
+    canvas.print(uiStr(STR_MINUTES));
+
+    canvas.setCursor(0, 4);
+    canvas.print(uiStr(STR_SWITCHES));
+    canvas.print(switchCount);
+    canvas.print(uiStr(STR_PER_HOUR));
 
     if (waterSensorPresent)
     {
-      cursorX = 0;
-      cursorY = 5;
-      oled.setCursor(cursorX, cursorY);
-      oled.print("Вода:");
-      oled.print(waterRawValue);
-      oled.print("/");
-      oled.print(waterThreshold);
-    }
-
-    cursorX = 0;
-    cursorY = 7;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("ДЛ-выход");
-    oled.update();
+      canvas.setCursor(0, 5);
+      canvas.print(uiStr(STR_WATER));
+      canvas.print(waterRawValue);
+      canvas.print(F("/"));
+      canvas.print(waterThreshold);
+    }
+
+    canvas.setCursor(0, 7);
+    canvas.print(uiStr(STR_HINT_HOLD_EXIT));
+    sendFrame();
   }
 
-  void drawCalibrationScreen(float currentTemp, float currentHum,
-                             float tempCal, float humCal, bool editingTemp)
+  // Показания целыми, поправки с десятыми
+  void drawCalibrationScreen(Deci currentTemp, Deci currentHum,
+                             Deci tempCal, Deci humCal, bool editingTemp)
   {
-    oled.clear();
-    cursorX = 15;
-    cursorY = 0;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(1);
-    oled.print("КАЛИБРОВКА");
-    line(0, 1, 127, 1);
-
-    cursorX = 0;
-    cursorY = 2;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("Т:");
-    oled.print((int)currentTemp);
-    oled.print("C В:");
-    oled.print((int)currentHum);
-    oled.print("%");
-
-    cursorX = 0;
-    cursorY = 4;
-    oled.setCursor(cursorX, cursorY);
+    beginFrame();
+    canvas.setCursor(15, 0);
+    canvas.setScale(1);
+    canvas.print(uiStr(STR_CAL_TITLE));
+    line(0, 10, 127, 10);
+
+    canvas.setCursor(0, 2);
+    canvas.print(uiStr(STR_CAL_TEMP_NOW));
+    canvas.print(deciTrunc(currentTemp));
+    canvas.print(uiStr(STR_CAL_HUM_NOW));
+    canvas.print(deciTrunc(currentHum));
+    canvas.print(F("%"));
+
+    canvas.setCursor(0, 4);
     if (editingTemp)
-      oled.print("> ");
-    oled.print("КорТ:");
+      canvas.print(F("> "));
+    canvas.print(uiStr(STR_CAL_TEMP));
     if (tempCal >= 0)
-      oled.print("+");
-    oled.print((int)tempCal);
+      canvas.print(F("+"));
+    deciPrint(canvas, tempCal);
 
-    cursorX = 0;
-    cursorY = 5;
-    oled.setCursor(cursorX, cursorY);
+    canvas.setCursor(0, 5);
     if (!editingTemp)
-      oled.print("> ");
-    oled.print("КорВ:");
+      canvas.print(F("> "));
+    canvas.print(uiStr(STR_CAL_HUM));
     if (humCal >= 0)
-      oled.print("+");
-    oled.print((int)humCal);
+      canvas.print(F("+"));
+    deciPrint(canvas, humCal);
 
-    cursorX = 0;
-    cursorY = 7;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("КН- след ДЛ-OK");
-    oled.update();
+    canvas.setCursor(0, 7);
+    canvas.print(uiStr(STR_HINT_CAL));
+    sendFrame();
   }
 
   void drawWaterCalibrationScreen(int currentValue, uint16_t threshold,
                                   bool sensorPresent, uint8_t waterPercent)
   {
-    oled.clear();
-    cursorX = 10;
-    cursorY = 0;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(1);
-    oled.print("ПОРОГ ВОДЫ");
-    line(0, 1, 127, 1);
-
-    cursorX = 0;
-    cursorY = 2;
-    oled.setCursor(cursorX, cursorY);
+    beginFrame();
+    canvas.setCursor(10, 0);
+    canvas.setScale(1);
+    canvas.print(uiStr(STR_WATER_CAL_TITLE));
+    line(0, 10, 127, 10);
+
+    canvas.setCursor(0, 2);
     if (!sensorPresent)
-      oled.print("НЕТ ДАТЧИКА!");
+      canvas.print(uiStr(STR_NO_SENSOR));
     else
     {
-      oled.print("Текущий:");
-      oled.print(currentValue);
-      cursorX = 0;
-      cursorY = 3;
-      oled.setCursor(cursorX, cursorY);
-      oled.print("Порог:");
-      oled.print(threshold);
+      canvas.print(uiStr(STR_CURRENT));
+      canvas.print(currentValue);
+      canvas.setCursor(0, 3);
+      canvas.print(uiStr(STR_THRESHOLD));
+      canvas.print(threshold);
       if ((uint16_t)currentValue < threshold)
       {
-        cursorX = 0;
-        cursorY = 4;
-        oled.setCursor(cursorX, cursorY);
-        oled.print("НИЗКАЯ ВОДА!");
+        canvas.setCursor(0, 4);
+        canvas.print(uiStr(STR_LOW_WATER));
       }
-      cursorX = 0;
-      cursorY = 5;
-      oled.setCursor(cursorX, cursorY);
-      oled.print("Уровень:");
-      oled.print(waterPercent);
-      oled.print("%");
-    }
-
-    cursorX = 0;
-    cursorY = 7;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("КН-меню ДЛ-сохр");
-    oled.update();
+      canvas.setCursor(0, 5);
+      canvas.print(uiStr(STR_LEVEL));
+      canvas.print(waterPercent);
+      canvas.print(F("%"));
+    }
+
+    canvas.setCursor(0, 7);
+    canvas.print(uiStr(STR_HINT_WATER_CAL));
+    sendFrame();
   }
 
   // Экран ручного режима
   void drawManualScreen(bool isOn)
   {
-    oled.clear();
-    cursorX = 25;
-    cursorY = 0;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(1);
-    oled.print("РУЧНОЙ РЕЖИМ");
-    line(0, 1, 127, 1);
-
-    cursorX = 20;
-    cursorY = 3;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(2);
+    beginFrame();
+    canvas.setCursor(25, 0);
+    canvas.setScale(1);
+    canvas.print(uiStr(STR_MANUAL_TITLE));
+    line(0, 10, 127, 10);
+
+    canvas.setCursor(20, 3);
+    canvas.setScale(2);
     if (isOn) {
-      oled.print("ВКЛ");
+      canvas.print(uiStr(STR_ON));
     } else {
-      oled.print("ВЫКЛ");
+      canvas.print(uiStr(STR_OFF));
     }
 
-    cursorX = 0;
-    cursorY = 6;
-    oled.setCursor(cursorX, cursorY);
-    oled.setScale(1);
-    oled.print("Поворот:перекл");
+    canvas.setCursor(0, 6);
+    canvas.setScale(1);
+    canvas.print(uiStr(STR_HINT_TOGGLE));
 
-    cursorX = 0;
-    cursorY = 7;
-    oled.setCursor(cursorX, cursorY);
-    oled.print("КН-выход");
+    canvas.setCursor(0, 7);
+    canvas.print(uiStr(STR_HINT_CLICK_EXIT));
 
-    oled.update();
+    sendFrame();
   }
 
   void clear()
   {
-    oled.clear();
+    beginFrame();
   }
 
   void update()
   {
-    oled.update();
+    sendFrame();
   }
 
-  void setCursor(uint8_t x, uint8_t y)
+  // Только страницы из маски: строки, записанные после clear(),
+  // заменяют их целиком, остальной экран не трогается
+  void updatePages(uint8_t pages)
   {
-    cursorX = x;
-    cursorY = y;
-    oled.setCursor(x, y);
+    sendFrame(pages);
   }
 
-  void print(const char *t) { oled.print(t); }
-  void print(const __FlashStringHelper *t) { oled.print(t); }
-  void print(int v) { oled.print(v); }
-  void print(float v, int d = 1) { oled.print((int)v); }
-  void setScale(uint8_t s)
-  {
-    textScale = constrain(s, 1, 4);
-    oled.setScale(textScale);
-  }
+  void setCursor(uint8_t x, uint8_t y) { canvas.setCursor(x, y); }
+
+  void print(const char *t) { canvas.print(t); }
+  void print(const __FlashStringHelper *t) { canvas.print(t); }
+  void print(StringId id) { canvas.print(uiStr(id)); }
+  void print(int v) { canvas.print(v); }
+  void print(unsigned long v) { canvas.print(v); }
+  void setScale(uint8_t s) { canvas.setScale(constrain(s, 1, 4)); }
 
   void drawRect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1, bool fill = false)
   {
-    oled.rect(x0, y0, x1, y1, fill ? OLED_FILL : OLED_STROKE);
+    canvas.rect(x0, y0, x1, y1, fill ? OLED_FILL : OLED_STROKE);
   }
 
+  // Инверсия того, что уже нарисовано в прямоугольнике
   void invertRect(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1)
   {
-  oled.rect(x0, y0, x1, y1, OLED_FILL);
+    canvas.rect(x0, y0, x1, y1, CANVAS_XOR);
   }
 };
 
@@ -1,61 +1,205 @@
 /*
  * МОДУЛЬ ЭНКОДЕРА
+ * Квадратурный декодер на прерываниях INT0/INT1 (D2/D3),
+ * кнопка опрашивается в прерывании тика HAL (~1 кГц).
+ * События складываются в кольцевой буфер: пишут только
+ * прерывания (на AVR они не вложены), читает только loop().
  */
 
 #ifndef ENCODER_H
 #define ENCODER_H
 
-#include <Arduino.h>
-#include <GyverEncoder.h>
+#include "hal.h"
 #include "config.h"
 
+enum EncoderEvent {
+  ENC_EVENT_NONE = 0,
+  ENC_EVENT_RIGHT = 1,
+  ENC_EVENT_LEFT = 2,
+  ENC_EVENT_PRESS = 3,
+  ENC_EVENT_CLICK = 4,
+  ENC_EVENT_DOUBLE = 5,
+  ENC_EVENT_HOLD = 6
+};
+
+// Флаг быстрого вращения (добавляется к ENC_EVENT_RIGHT/LEFT)
+#define ENC_EVENT_FAST  0x80
+#define ENC_EVENT_MASK  0x7F
+
+#define ENCODER_QUEUE_MASK (ENCODER_QUEUE_SIZE - 1)
+
 class EncoderModule {
 private:
-  Encoder enc;
-  
+  // Кольцевой буфер событий (один писатель - ISR, один читатель - loop)
+  volatile uint8_t queue[ENCODER_QUEUE_SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+  volatile uint8_t overflowCount;
+
+  // Состояние квадратурного декодера (только ISR)
+  uint8_t quadState;
+  int8_t quadAccum;
+  unsigned long lastDetentTime;
+
+  // Состояние кнопки (только ISR, тики по ~1 мс)
+  bool btnPressed;
+  bool btnHoldSent;
+  uint8_t btnDebounce;
+  uint8_t btnClicks;
+  uint16_t btnTicks;
+
+  unsigned long lastActivity;
+
+  static EncoderModule*& instance() {
+    static EncoderModule* inst = nullptr;
+    return inst;
+  }
+
+  void push(uint8_t event) {
+    uint8_t next = (head + 1) & ENCODER_QUEUE_MASK;
+    if (next == tail) {
+      if (overflowCount < 255) overflowCount++;
+      return;
+    }
+    queue[head] = event;
+    head = next;
+  }
+
+  void pushRotation(uint8_t event) {
+    unsigned long now = millis();
+    if (now - lastDetentTime < ENCODER_FAST_THRESHOLD) event |= ENC_EVENT_FAST;
+    lastDetentTime = now;
+    push(event);
+  }
+
 public:
-  EncoderModule() : enc(ENCODER_CLK, ENCODER_DT, ENCODER_SW) {}
+  EncoderModule() : head(0), tail(0), overflowCount(0),
+                    quadState(0), quadAccum(0), lastDetentTime(0),
+                    btnPressed(false), btnHoldSent(false), btnDebounce(0),
+                    btnClicks(0), btnTicks(0), lastActivity(0) {}
 
   void begin() {
-    enc.setType(TYPE2);
-  }
+    pinMode(ENCODER_CLK, INPUT_PULLUP);
+    pinMode(ENCODER_DT, INPUT_PULLUP);
+    pinMode(ENCODER_SW, INPUT_PULLUP);
+
+    quadState = (digitalRead(ENCODER_CLK) << 1) | digitalRead(ENCODER_DT);
+    lastActivity = millis();
+    instance() = this;
 
-  void tick() {
-    enc.tick();
+    attachInterrupt(digitalPinToInterrupt(ENCODER_CLK), isrRotation, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(ENCODER_DT), isrRotation, CHANGE);
+
+    // Опрос кнопки по тику ~1 мс
+    halTickBegin();
   }
 
-  // Проверка - было ли вращение (любое направление)
-  bool isTurn() {
-    return enc.isTurn();
+  // ==========================================================================
+  // ОБРАБОТЧИКИ ПРЕРЫВАНИЙ
+  // ==========================================================================
+
+  static void isrRotation() {
+    instance()->onRotation();
   }
 
-  // Возвращает: 1 = вправо, -1 = влево, 0 = нет вращения
-  int8_t getDelta() {
-    if (enc.isRight()) return 1;
-    if (enc.isLeft()) return -1;
-    return 0;
+  static void isrTimer() {
+    if (instance()) instance()->onTimerTick();
   }
 
-  int8_t getDirection() {
-    return getDelta();
+  // Смена уровня на CLK или DT
+  void onRotation() {
+    // Таблица переходов: индекс = (старое состояние << 2) | новое
+    static const int8_t steps[16] = {
+       0, -1,  1,  0,
+       1,  0,  0, -1,
+      -1,  0,  0,  1,
+       0,  1, -1,  0
+    };
+
+    uint8_t s = (digitalRead(ENCODER_CLK) << 1) | digitalRead(ENCODER_DT);
+    quadAccum += steps[(quadState << 2) | s];
+    quadState = s;
+
+    // Решение принимаем в точке покоя, дребезг между ними взаимно гасится.
+    // Полушаговый энкодер стоит и на 00, и на 11, полношаговый - на 11.
+    // Половины переходов хватает: потерянный на быстром вращении фронт
+    // щелчок не отменяет
+#if ENCODER_STEPS_PER_DETENT == 2
+    bool rest = (s == 0x00 || s == 0x03);
+#else
+    bool rest = (s == 0x03);
+#endif
+    if (rest) {
+      if (quadAccum >= ENCODER_STEPS_PER_DETENT / 2) pushRotation(ENCODER_REVERSE ? ENC_EVENT_LEFT : ENC_EVENT_RIGHT);
+      else if (quadAccum <= -ENCODER_STEPS_PER_DETENT / 2) pushRotation(ENCODER_REVERSE ? ENC_EVENT_RIGHT : ENC_EVENT_LEFT);
+      quadAccum = 0;
+    }
   }
 
-  bool isClick() { return enc.isClick(); }
-  bool isDouble() { return enc.isDouble(); }
-  bool isLongPress() { return enc.isHolded(); }
-  void clearLongPress() {}
+  // Опрос кнопки: антидребезг, клик, двойной клик, удержание
+  void onTimerTick() {
+    bool sample = (digitalRead(ENCODER_SW) == LOW);
+
+    if (sample != btnPressed) {
+      if (++btnDebounce < ENCODER_DEBOUNCE_TIME) return;
+      btnDebounce = 0;
+      btnPressed = sample;
+      btnTicks = 0;
 
-  bool isFastRotate() { return enc.isFastR() || enc.isFastL(); }
+      if (btnPressed) {
+        btnHoldSent = false;
+        push(ENC_EVENT_PRESS);
+      } else if (!btnHoldSent) {
+        btnClicks++;
+        if (btnClicks >= 2) {
+          push(ENC_EVENT_DOUBLE);
+          btnClicks = 0;
+        }
+      }
+      return;
+    }
+    btnDebounce = 0;
 
-  bool isRight() { return enc.isRight(); }
-  bool isLeft() { return enc.isLeft(); }
+    if (btnTicks < 0xFFFF) btnTicks++;
 
-  void resetPosition() {}
+    if (btnPressed) {
+      if (!btnHoldSent && btnTicks >= LONG_PRESS_TIME) {
+        push(ENC_EVENT_HOLD);
+        btnHoldSent = true;
+        btnClicks = 0;
+      }
+    } else if (btnClicks > 0 && btnTicks >= ENCODER_DOUBLE_TIMEOUT) {
+      // Второго нажатия не было - одиночный клик
+      push(ENC_EVENT_CLICK);
+      btnClicks = 0;
+    }
+  }
+
+  // ==========================================================================
+  // ЧТЕНИЕ СОБЫТИЙ (только из loop)
+  // ==========================================================================
 
-  bool isPressed() { return enc.isHold(); }
-  bool isPress() { return enc.isPress(); }
+  bool hasEvent() const {
+    return head != tail;
+  }
 
-  void resetStates() { enc.resetStates(); }
+  // Возвращает ENC_EVENT_NONE, если событий нет
+  uint8_t popEvent() {
+    if (head == tail) return ENC_EVENT_NONE;
+    uint8_t event = queue[tail];
+    tail = (tail + 1) & ENCODER_QUEUE_MASK;
+    lastActivity = millis();
+    return event;
+  }
+
+  // Время последнего прочитанного события (для автозатемнения)
+  unsigned long getLastActivity() const { return lastActivity; }
+
+  uint8_t getOverflowCount() const { return overflowCount; }
 };
 
+HAL_ISR_TICK() {
+  EncoderModule::isrTimer();
+}
+
 #endif // ENCODER_H
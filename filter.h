@@ -0,0 +1,94 @@
+/*
+ * ФИЛЬТР ВЛАЖНОСТИ
+ * Одиночный выброс DHT22 у верхнего порога выключает увлажнитель
+ * и тратит одно из MAX_SWITCHES_PER_HOUR переключений. Перед
+ * управлением замер проходит две ступени:
+ *   - медиана последних FILTER_MEDIAN_SIZE замеров - выбросы в один
+ *     замер не проходят совсем;
+ *   - сглаживание: экспоненциальное (вес нового замера 1/2^shift)
+ *     или одномерный Калман, который сам подбирает вес по шуму.
+ * Все в целых: значения в десятых долях (fixed.h), внутреннее
+ * состояние - с FILTER_FRACTION_BITS дробными битами
+ */
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "hal.h"
+#include "config.h"
+#include "fixed.h"
+
+#define FILTER_FRACTION_BITS  4
+
+class HumidityFilter {
+private:
+  Deci ring[FILTER_MEDIAN_SIZE];
+  uint8_t ringPos;
+  uint8_t ringCount;
+
+  int32_t state;      // Сглаженное значение << FILTER_FRACTION_BITS
+  uint16_t variance;  // Калман: дисперсия оценки, (0,1 %)^2
+  bool primed;        // Был хотя бы один замер
+  Deci output;
+
+  Deci median() const {
+    Deci sorted[FILTER_MEDIAN_SIZE];
+    for (uint8_t i = 0; i < ringCount; i++) {
+      // Вставка: N не больше 7
+      Deci v = ring[i];
+      uint8_t j = i;
+      for (; j > 0 && sorted[j - 1] > v; j--) sorted[j] = sorted[j - 1];
+      sorted[j] = v;
+    }
+    return sorted[ringCount / 2];
+  }
+
+  Deci smooth(Deci v) {
+    int32_t z = (int32_t)v << FILTER_FRACTION_BITS;
+    if (!primed) {
+      state = z;
+      variance = FILTER_KALMAN_R;
+      primed = true;
+    }
+#if FILTER_SMOOTH == FILTER_SMOOTH_EMA
+    state += (z - state) >> FILTER_EMA_SHIFT;
+#elif FILTER_SMOOTH == FILTER_SMOOTH_KALMAN
+    // Прогноз: значение то же, неопределенность растет на Q.
+    // Поправка: вес замера K = P / (P + R), в 1/256
+    uint16_t p = variance + FILTER_KALMAN_Q;
+    uint16_t gain = ((uint32_t)p << 8) / (p + FILTER_KALMAN_R);
+    state += ((z - state) * gain) >> 8;
+    variance = ((uint32_t)p * (256 - gain)) >> 8;
+#else
+    state = z;
+#endif
+    // Округление к ближайшему, state может быть отрицательным
+    return (Deci)((state + (1 << (FILTER_FRACTION_BITS - 1))) >> FILTER_FRACTION_BITS);
+  }
+
+public:
+  HumidityFilter() { reset(); }
+
+  // Забыть историю: следующий замер проходит как есть
+  void reset() {
+    ringPos = 0;
+    ringCount = 0;
+    state = 0;
+    variance = 0;
+    primed = false;
+    output = 0;
+  }
+
+  Deci add(Deci v) {
+    ring[ringPos] = v;
+    ringPos = ringPos + 1 >= FILTER_MEDIAN_SIZE ? 0 : ringPos + 1;
+    if (ringCount < FILTER_MEDIAN_SIZE) ringCount++;
+    output = smooth(median());
+    return output;
+  }
+
+  Deci get() const { return output; }
+  bool isPrimed() const { return primed; }
+};
+
+#endif // FILTER_H
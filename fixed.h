@@ -0,0 +1,51 @@
+/*
+ * ЧИСЛА С ФИКСИРОВАННОЙ ТОЧКОЙ
+ * У ATmega328P нет FPU: каждая операция с float - вызов soft-float
+ * на сотни тактов, а сама библиотека занимает flash. Температура и
+ * влажность идут по прошивке в десятых долях, как их отдает DHT22:
+ * 22,5 °C = 225, 45,0 % = 450. Сложение и сравнение - обычные
+ * операции int16_t, константы - DECI() на этапе компиляции
+ */
+
+#ifndef FIXED_H
+#define FIXED_H
+
+#include "hal.h"
+
+// Десятые доли: °C, % влажности, поправки калибровки
+typedef int16_t Deci;
+
+#define DECI_SCALE 10
+
+// Константа в десятых: DECI(2.5) = 25. Только для констант - иначе
+// выражение с float попадет в прошивку
+#define DECI(x) ((Deci)((x) * DECI_SCALE + ((x) < 0 ? -0.5 : 0.5)))
+
+inline Deci deciFromInt(int16_t v) { return v * DECI_SCALE; }
+
+// Целая часть с отбрасыванием дроби, как (int) у float
+inline int16_t deciTrunc(Deci v) { return v / DECI_SCALE; }
+
+// Ближайшее целое, половина - от нуля
+inline int16_t deciRound(Deci v) {
+  return (v + (v < 0 ? -DECI_SCALE / 2 : DECI_SCALE / 2)) / DECI_SCALE;
+}
+
+// "-2.5", "22.0": вывод в Print или PageCanvas. Возвращает число символов
+template <typename Out>
+uint8_t deciPrint(Out& out, Deci v) {
+  uint8_t chars = 3;
+  if (v < 0) {
+    out.print(F("-"));
+    v = -v;
+    chars++;
+  }
+  int16_t whole = v / DECI_SCALE;
+  out.print(whole);
+  out.print(F("."));
+  out.print(v % DECI_SCALE);
+  for (; whole >= 10; whole /= 10) chars++;
+  return chars;
+}
+
+#endif // FIXED_H
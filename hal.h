@@ -0,0 +1,29 @@
+/*
+ * АППАРАТНАЯ АБСТРАКЦИЯ (HAL)
+ * Модули подключают только этот файл. Для AVR это ядро Arduino,
+ * EEPROM, microWire, GyverOLED и avr-libc плюс обертки над регистрами
+ * (hal_avr.h). Для сборки на ПК - их эмуляция в виртуальном
+ * времени (host/hal_host.h)
+ *
+ * Сверх API Arduino модули используют:
+ *   halPinChangeBegin(pin), halPinChangeEnable(pin, on) и
+ *   HAL_ISR_PIN_CHANGE() { ... } - прерывание по смене уровня;
+ *   halTickBegin() и HAL_ISR_TICK() { ... } - тик ~1 мс;
+ *   halTwiBegin/Start/Write/Receive/Data/Stop/Status() и HAL_ISR_TWI() { ... } -
+ *   обмен по I2C в прерываниях, halTwiWait() - ожидание шины;
+ *   halStaticBytes/HeapEnd/StackPointer/RamTop/StackUntouched() -
+ *   раскладка SRAM и запас стека (на ПК - нули)
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#if defined(ARDUINO_ARCH_AVR)
+  #define HAL_AVR 1
+  #include "hal_avr.h"
+#else
+  #define HAL_HOST 1
+  #include "host/hal_host.h"
+#endif
+
+#endif // HAL_H
@@ -0,0 +1,139 @@
+/*
+ * HAL ДЛЯ AVR (Arduino Nano, ATmega328P)
+ * Библиотеки подключаются как есть, здесь только доступ
+ * к регистрам, который раньше был разбросан по модулям
+ */
+
+#ifndef HAL_AVR_H
+#define HAL_AVR_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <avr/wdt.h>
+#include <avr/sleep.h>
+#include <avr/power.h>
+// Wire не подключается: его обработчик TWI_vect занят очередью twi.h
+#define USE_MICRO_WIRE
+#include <GyverOLED.h>
+
+// ============================================================================
+// ПРЕРЫВАНИЕ ПО СМЕНЕ УРОВНЯ (PCINT)
+// ============================================================================
+
+// Обработчик один на порт D (D0-D7)
+#define HAL_ISR_PIN_CHANGE() ISR(PCINT2_vect)
+
+inline void halPinChangeBegin(uint8_t pin) {
+  PCICR |= _BV(digitalPinToPCICRbit(pin));
+}
+
+inline void halPinChangeEnable(uint8_t pin, bool enable) {
+  if (enable) {
+    PCIFR = _BV(digitalPinToPCICRbit(pin));  // Сброс флага записью единицы
+    *digitalPinToPCMSK(pin) |= _BV(digitalPinToPCMSKbit(pin));
+  } else {
+    *digitalPinToPCMSK(pin) &= ~_BV(digitalPinToPCMSKbit(pin));
+  }
+}
+
+// ============================================================================
+// ТИК ~1 мс
+// ============================================================================
+
+// Timer0 уже тикает для millis(): совпадение с OCR0B дает
+// второе прерывание раз в ~1 мс (ШИМ на D5 не используется)
+#define HAL_ISR_TICK() ISR(TIMER0_COMPB_vect)
+
+inline void halTickBegin() {
+  OCR0B = 0x80;
+  TIMSK0 |= _BV(OCIE0B);
+}
+
+// ============================================================================
+// TWI (I2C) ПО ПРЕРЫВАНИЯМ
+// ============================================================================
+
+#define HAL_ISR_TWI() ISR(TWI_vect)
+
+// Коды TWSR (биты 7-3) для ведущего передатчика и приемника
+#define HAL_TWI_START     0x08
+#define HAL_TWI_ADDR_ACK  0x18
+#define HAL_TWI_DATA_ACK  0x28
+#define HAL_TWI_READ_ACK  0x40  // SLA+R, устройство ответило
+#define HAL_TWI_RX_ACK    0x50  // Байт принят, отправлен ACK
+#define HAL_TWI_RX_NACK   0x58  // Последний байт принят, отправлен NACK
+
+inline void halTwiBegin(unsigned long clock) {
+  TWSR = 0;   // Предделитель 1
+  TWBR = ((F_CPU / clock) - 16) / 2;
+  TWCR = _BV(TWEN);
+}
+
+// Вызывается при запрещенных прерываниях. STOP, выданный ISR за
+// опустевшей очередью, еще может идти: запись TWSTA поверх TWSTO его
+// затрет. Ждем, как twi_stop() в Wire, - несколько мкс
+inline void halTwiStart() {
+  while (TWCR & _BV(TWSTO)) {}
+  TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+}
+
+// Повторный старт из ISR тоже дает HAL_TWI_START: 0x10 сводится к 0x08
+inline uint8_t halTwiStatus() {
+  uint8_t status = TWSR & 0xF8;
+  return status == 0x10 ? HAL_TWI_START : status;
+}
+
+inline void halTwiWrite(uint8_t data) {
+  TWDR = data;
+  TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+}
+
+// Прием следующего байта: ack = false для последнего
+inline void halTwiReceive(bool ack) {
+  TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE) | (ack ? _BV(TWEA) : 0);
+}
+
+inline uint8_t halTwiData() { return TWDR; }
+
+// STOP, а если next - сразу START следующей транзакции
+inline void halTwiStop(bool next) {
+  TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN) |
+         (next ? _BV(TWSTA) | _BV(TWIE) : 0);
+}
+
+// Ожидание места в очереди: байты отправляет прерывание
+inline void halTwiWait() {}
+
+// ============================================================================
+// ПАМЯТЬ (SRAM 2 КБ)
+// ============================================================================
+
+// Снизу вверх: .data, .bss, куча до __brkval, свободно, стек от RAMEND.
+// Свободное место заливается HAL_STACK_PAINT до конструкторов, стек
+// затирает заливку - нетронутый остаток и есть запас стека
+#define HAL_STACK_PAINT 0xC5
+
+extern char __data_start;
+extern char __heap_start;
+extern char* __brkval;
+
+// .init3: SP уже установлен и r1 обнулен, .data и .bss еще не заполнены.
+// naked - без пролога и ret, выполнение идет дальше в .init4
+__attribute__((naked, used, section(".init3"))) static void halStackPaint() {
+  for (uint8_t* p = (uint8_t*)&__heap_start; p < (uint8_t*)SP; p++)
+    *p = HAL_STACK_PAINT;
+}
+
+inline uint16_t halStaticBytes() { return &__heap_start - &__data_start; }
+inline uint16_t halHeapEnd() { return __brkval ? (uint16_t)__brkval : (uint16_t)&__heap_start; }
+inline uint16_t halStackPointer() { return SP; }
+inline uint16_t halRamTop() { return RAMEND + 1; }
+
+// Байт заливки над кучей, которых стек не касался с момента старта
+inline uint16_t halStackUntouched() {
+  const uint8_t* p = (const uint8_t*)halHeapEnd();
+  while ((uint16_t)p < SP && *p == HAL_STACK_PAINT) p++;
+  return (uint16_t)p - halHeapEnd();
+}
+
+#endif // HAL_AVR_H
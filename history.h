@@ -0,0 +1,201 @@
+/*
+ * МОДУЛЬ ИСТОРИИ ВЛАЖНОСТИ
+ * Ярусы поверх живого графика дисплея (точка на каждый замер):
+ *   - минутные корзины за последний час;
+ *   - корзины по HISTORY_PERIOD_MINUTES минут за последние сутки.
+ * Корзина - 2 байта: среднее, размах вниз и вверх от среднего и доля
+ * времени работы увлажнителя. Суточные корзины считаются по тем же
+ * замерам, что и минутные, а не по округленным минутным.
+ * Период замера переменный (sampling.h): замер входит в корзину с
+ * весом - секундами с прошлого замера
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "hal.h"
+#include "config.h"
+#include "lang.h"
+#include "fixed.h"
+
+// Упакованная корзина:
+//   биты 15-9 - среднее, % (0-100; 127 - нет данных)
+//   биты 8-6  - среднее минус минимум, код размаха historySpread
+//   биты 5-3  - максимум минус среднее, код размаха
+//   биты 2-0  - доля работы увлажнителя, восьмые (7 - от 7/8 до всего времени)
+typedef uint16_t HistoryBucket;
+
+#define HISTORY_EMPTY        0xFE00
+#define HISTORY_SPREAD_MAX   7
+
+// Размах по коду, %: мелкий - точно, крупный - грубее. Корзина,
+// накрывшая цикл увлажнителя, легко уходит на 10-20 % от среднего.
+// Размах округляется вверх, больше 25 % показывается как 25 %
+static const uint8_t historySpread[HISTORY_SPREAD_MAX + 1] PROGMEM = {
+  0, 1, 2, 4, 7, 11, 16, 25
+};
+
+enum HistoryView {
+  HISTORY_VIEW_1H = 0,   // Все минутные корзины
+  HISTORY_VIEW_6H = 1,   // Суточные за последние 6 ч
+  HISTORY_VIEW_24H = 2,  // Все суточные
+  HISTORY_VIEW_COUNT = 3
+};
+
+// Накопитель открытой корзины
+struct HistoryAcc {
+  uint32_t sum;      // Десятые доли % на секунды
+  uint16_t count;    // Секунды
+  uint16_t running;  // Секунды работы увлажнителя
+  uint8_t minHum;    // %
+  uint8_t maxHum;
+};
+
+class History {
+private:
+  HistoryBucket minutes[HISTORY_MINUTES];
+  HistoryBucket periods[HISTORY_PERIODS];
+  uint8_t minuteIdx, minuteCount;
+  uint8_t periodIdx, periodCount;
+  uint8_t minutesInPeriod;
+
+  HistoryAcc minuteAcc;
+  HistoryAcc periodAcc;
+  unsigned long minuteStart;
+  uint16_t closed;   // Закрыто минутных корзин, счетчик с переполнением
+
+  static void resetAcc(HistoryAcc& a) {
+    a.sum = 0;
+    a.count = 0;
+    a.running = 0;
+    a.minHum = 255;
+    a.maxHum = 0;
+  }
+
+  static void addToAcc(HistoryAcc& a, uint16_t hum10, bool running, uint8_t weight) {
+    uint8_t h = (hum10 + 5) / 10;
+    a.sum += (uint32_t)hum10 * weight;
+    a.count += weight;
+    if (running) a.running += weight;
+    if (h < a.minHum) a.minHum = h;
+    if (h > a.maxHum) a.maxHum = h;
+  }
+
+  static uint8_t spreadCode(uint8_t delta) {
+    uint8_t code = 0;
+    while (code < HISTORY_SPREAD_MAX && pgm_read_byte(&historySpread[code]) < delta) code++;
+    return code;
+  }
+
+  static HistoryBucket pack(const HistoryAcc& a) {
+    if (a.count == 0) return HISTORY_EMPTY;
+    uint8_t mean = (a.sum / a.count + 5) / 10;
+    uint8_t lo = mean > a.minHum ? mean - a.minHum : 0;
+    uint8_t hi = a.maxHum > mean ? a.maxHum - mean : 0;
+    uint8_t run = ((uint32_t)a.running * 8 + a.count / 2) / a.count;
+    if (run > 7) run = 7;
+    return ((HistoryBucket)mean << 9) | (spreadCode(lo) << 6) | (spreadCode(hi) << 3) | run;
+  }
+
+  void closeMinute() {
+    minutes[minuteIdx] = pack(minuteAcc);
+    minuteIdx = (minuteIdx + 1) % HISTORY_MINUTES;
+    if (minuteCount < HISTORY_MINUTES) minuteCount++;
+
+    // Суточная корзина копит сами замеры
+    periodAcc.sum += minuteAcc.sum;
+    periodAcc.count += minuteAcc.count;
+    periodAcc.running += minuteAcc.running;
+    if (minuteAcc.minHum < periodAcc.minHum) periodAcc.minHum = minuteAcc.minHum;
+    if (minuteAcc.maxHum > periodAcc.maxHum) periodAcc.maxHum = minuteAcc.maxHum;
+    resetAcc(minuteAcc);
+
+    if (++minutesInPeriod >= HISTORY_PERIOD_MINUTES) {
+      periods[periodIdx] = pack(periodAcc);
+      periodIdx = (periodIdx + 1) % HISTORY_PERIODS;
+      if (periodCount < HISTORY_PERIODS) periodCount++;
+      resetAcc(periodAcc);
+      minutesInPeriod = 0;
+    }
+    closed++;
+  }
+
+public:
+  History() : minuteIdx(0), minuteCount(0), periodIdx(0), periodCount(0),
+              minutesInPeriod(0), minuteStart(0), closed(0) {
+    resetAcc(minuteAcc);
+    resetAcc(periodAcc);
+  }
+
+  void begin() {
+    minuteStart = millis();
+  }
+
+  // Закрывает корзины, время которых вышло. Вызывается с каждым
+  // измерением, в том числе неудачным - пропуски остаются пустыми
+  void tick() {
+    uint8_t guard = 0;
+    while (millis() - minuteStart >= HISTORY_MINUTE_MS && guard++ < 10) {
+      closeMinute();
+      minuteStart += HISTORY_MINUTE_MS;
+    }
+  }
+
+  // seconds - с прошлого замера, вес замера в корзине. После
+  // пропусков замер представляет не больше минуты
+  void addSample(Deci hum, bool running, uint16_t seconds) {
+    tick();
+    uint8_t weight = constrain(seconds, 1, HISTORY_MINUTE_MS / 1000);
+    addToAcc(minuteAcc, constrain(hum, 0, DECI(100)), running, weight);
+  }
+
+  // Меняется с закрытием каждой минутной корзины
+  uint16_t getVersion() const { return closed; }
+
+  static uint8_t getViewSize(uint8_t view) {
+    switch (view) {
+      case HISTORY_VIEW_1H: return HISTORY_MINUTES;
+      case HISTORY_VIEW_6H:
+        return HISTORY_PERIODS < 360 / HISTORY_PERIOD_MINUTES ? HISTORY_PERIODS : 360 / HISTORY_PERIOD_MINUTES;
+      case HISTORY_VIEW_24H: return HISTORY_PERIODS;
+    }
+    return 0;
+  }
+
+  static const __FlashStringHelper* getViewName(uint8_t view) {
+    switch (view) {
+      case HISTORY_VIEW_1H: return uiStr(STR_VIEW_1H);
+      case HISTORY_VIEW_6H: return uiStr(STR_VIEW_6H);
+      case HISTORY_VIEW_24H: return uiStr(STR_VIEW_24H);
+    }
+    return F("?");
+  }
+
+  // Корзина вида view, ago = 0 - последняя закрытая
+  HistoryBucket getBucket(uint8_t view, uint8_t ago) const {
+    if (view == HISTORY_VIEW_1H) {
+      if (ago >= minuteCount) return HISTORY_EMPTY;
+      return minutes[(minuteIdx + HISTORY_MINUTES - 1 - ago) % HISTORY_MINUTES];
+    }
+    if (ago >= periodCount) return HISTORY_EMPTY;
+    return periods[(periodIdx + HISTORY_PERIODS - 1 - ago) % HISTORY_PERIODS];
+  }
+
+  static bool isEmpty(HistoryBucket b) { return (b >> 9) > 100; }
+  static uint8_t getMean(HistoryBucket b) { return b >> 9; }
+
+  static uint8_t getMin(HistoryBucket b) {
+    uint8_t lo = pgm_read_byte(&historySpread[(b >> 6) & 7]);
+    return getMean(b) > lo ? getMean(b) - lo : 0;
+  }
+
+  static uint8_t getMax(HistoryBucket b) {
+    uint8_t hi = getMean(b) + pgm_read_byte(&historySpread[(b >> 3) & 7]);
+    return hi > 100 ? 100 : hi;
+  }
+
+  // Доля работы увлажнителя, восьмые: 0-7, 7 - от 7/8 до всего времени
+  static uint8_t getRun(HistoryBucket b) { return b & 7; }
+};
+
+#endif // HISTORY_H
@@ -0,0 +1,136 @@
+/*
+ * ЗАМЕР ОТРИСОВКИ ЭКРАНОВ НА ПК
+ * Экраны из bench.h рисуются на модели SSD1306, по каждому - число
+ * транзакций I2C, байт (с адресом) и время шины при 400 кГц на кадр.
+ * Процессорное время здесь не видно, его показывает команда 'b' на Nano.
+ *
+ *   display_bench [-n повторы] [-b эталон] [-s]
+ *
+ *   -n  отрисовок каждого экрана (1)
+ *   -b  файл с прошлым выводом: сравнить байты, код 1 при росте
+ *   -s  выводить экран после каждого замера
+ *
+ * Код возврата: 1 - байты выросли, 4 - список операций холста
+ * переполнялся
+ */
+
+#include <map>
+#include <string>
+
+#include "../config.h"
+#include "devices.h"
+#include "host.h"
+
+void setup();
+
+uint8_t benchCount();
+const char* benchName(uint8_t c);
+void benchFillGraph();
+void benchPrepare(uint8_t c);
+void benchDraw(uint8_t c);
+uint16_t canvasOverflows();
+
+struct BenchResult {
+  uint32_t transactions;
+  uint32_t bytes;
+  uint32_t busUs;
+};
+
+static Ssd1306Model oledModel;
+static Dht22Model dhtModel;
+
+static void usage() {
+  fprintf(stderr, "usage: display_bench [-n repeats] [-b baseline] [-s]\n");
+}
+
+// Строки вида "ИМЯ транзакции байты мкс", остальные пропускаются
+static std::map<std::string, uint32_t> loadBaseline(const char* path) {
+  std::map<std::string, uint32_t> bytes;
+  FILE* f = fopen(path, "r");
+  if (!f) return bytes;
+  char line[128], name[32];
+  unsigned transactions, count, us;
+  while (fgets(line, sizeof(line), f)) {
+    if (sscanf(line, "%31s %u %u %u", name, &transactions, &count, &us) == 4) {
+      bytes[name] = count;
+    }
+  }
+  fclose(f);
+  return bytes;
+}
+
+int main(int argc, char** argv) {
+  int repeats = 1;
+  const char* baselinePath = nullptr;
+  bool showScreen = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "-n" && hasValue) repeats = atoi(argv[++i]);
+    else if (arg == "-b" && hasValue) baselinePath = argv[++i];
+    else if (arg == "-s") showScreen = true;
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if (repeats < 1) repeats = 1;
+
+  std::map<std::string, uint32_t> baseline;
+  if (baselinePath) {
+    baseline = loadBaseline(baselinePath);
+    if (baseline.empty()) {
+      fprintf(stderr, "no data in %s\n", baselinePath);
+      return 2;
+    }
+  }
+
+  host::setSerialOutput(nullptr);
+  host::attachI2c(OLED_ADDRESS, &oledModel);
+  dhtModel.begin(DHT_PIN);
+  dhtModel.set(45.0, 22.5);
+  host::setAnalog(WATER_LEVEL_PIN, 600);
+
+  setup();
+  benchFillGraph();
+
+  printf("%-8s %6s %6s %7s\n", "screen", "trans", "bytes", "bus_us");
+  bool grew = false;
+  for (uint8_t c = 0; c < benchCount(); c++) {
+    uint32_t transactions = 0, bytes = 0;
+    uint64_t busUs = 0;
+    for (int i = 0; i < repeats; i++) {
+      benchPrepare(c);
+      host::resetI2cStats();
+      benchDraw(c);
+      const host::I2cStats& bus = host::i2cStats();
+      transactions += bus.transactions;
+      bytes += bus.bytes;
+      busUs += bus.busTimeUs;
+    }
+
+    BenchResult r;
+    r.transactions = transactions / repeats;
+    r.bytes = bytes / repeats;
+    r.busUs = (uint32_t)(busUs / repeats);
+
+    const char* name = benchName(c);
+    printf("%-8s %6u %6u %7u", name, r.transactions, r.bytes, r.busUs);
+    std::map<std::string, uint32_t>::const_iterator it = baseline.find(name);
+    if (it != baseline.end()) {
+      long delta = (long)r.bytes - (long)it->second;
+      printf("  %+ld", delta);
+      if (delta > 0) grew = true;
+    }
+    printf("\n");
+
+    if (showScreen) oledModel.dump(stdout);
+  }
+
+  if (canvasOverflows()) {
+    fprintf(stderr, "canvas overflow in %u frames\n", canvasOverflows());
+    return 4;
+  }
+  return grew ? 1 : 0;
+}
@@ -0,0 +1,389 @@
+/*
+ * МОДЕЛИ УСТРОЙСТВ ДЛЯ СБОРКИ НА ПК
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "devices.h"
+
+#define LOW  0
+#define HIGH 1
+
+// ============================================================================
+// SSD1306
+// ============================================================================
+
+Ssd1306Model::Ssd1306Model()
+  : addressingMode(2), colStart(0), colEnd(127), pageStart(0), pageEnd(7),
+    col(0), page(0), contrast(0x7F), displayOn(false),
+    cmdLength(0), cmdExpected(0), dataBytes(0), commandBytes(0) {
+  memset(ram, 0, sizeof(ram));
+}
+
+// Управляющий байт: бит 6 - данные/команды, бит 7 - после следующего
+// байта снова идет управляющий
+bool Ssd1306Model::onWrite(const uint8_t* bytes, uint8_t length) {
+  uint8_t i = 0;
+  while (i < length) {
+    uint8_t control = bytes[i++];
+    bool isData = control & 0x40;
+    bool single = control & 0x80;
+
+    while (i < length) {
+      if (isData) data(bytes[i++]);
+      else command(bytes[i++]);
+      if (single) break;
+    }
+  }
+  return true;
+}
+
+void Ssd1306Model::command(uint8_t byte) {
+  commandBytes++;
+  if (cmdLength == 0) {
+    // Количество аргументов у команд с параметрами
+    switch (byte) {
+      case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+      case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        cmdExpected = 1; break;
+      case 0x21: case 0x22: case 0xA3:
+        cmdExpected = 2; break;
+      case 0x29: case 0x2A:
+        cmdExpected = 5; break;
+      case 0x26: case 0x27:
+        cmdExpected = 6; break;
+      default:
+        cmdExpected = 0; break;
+    }
+  }
+  cmd[cmdLength++] = byte;
+  if (cmdLength > cmdExpected) {
+    execute();
+    cmdLength = 0;
+  }
+}
+
+void Ssd1306Model::execute() {
+  uint8_t c = cmd[0];
+  switch (c) {
+    case 0x20: addressingMode = cmd[1] & 0x03; return;
+    case 0x21:
+      colStart = cmd[1] & 0x7F; colEnd = cmd[2] & 0x7F; col = colStart;
+      return;
+    case 0x22:
+      pageStart = cmd[1] & 0x07; pageEnd = cmd[2] & 0x07; page = pageStart;
+      return;
+    case 0x81: contrast = cmd[1]; return;
+    case 0xAE: displayOn = false; return;
+    case 0xAF: displayOn = true; return;
+  }
+  // Страничный режим: номер страницы и половинки номера столбца
+  if (c >= 0xB0 && c <= 0xB7) page = c & 0x07;
+  else if (c <= 0x0F) col = (col & 0xF0) | c;
+  else if (c >= 0x10 && c <= 0x1F) col = (col & 0x0F) | ((c & 0x0F) << 4);
+}
+
+void Ssd1306Model::data(uint8_t byte) {
+  dataBytes++;
+  ram[page][col] = byte;
+
+  switch (addressingMode) {
+    case 0:   // Горизонтальный: по столбцам окна, затем следующая страница
+      if (col >= colEnd) {
+        col = colStart;
+        page = page >= pageEnd ? pageStart : page + 1;
+      } else {
+        col++;
+      }
+      break;
+    case 1:   // Вертикальный: по страницам окна, затем следующий столбец
+      if (page >= pageEnd) {
+        page = pageStart;
+        col = col >= colEnd ? colStart : col + 1;
+      } else {
+        page++;
+      }
+      break;
+    default:  // Страничный: только столбец, без перехода на другую страницу
+      if (col < 127) col++;
+      break;
+  }
+}
+
+void Ssd1306Model::dump(FILE* out) const {
+  static const char* const blocks[4] = { " ", "▀", "▄", "█" };
+
+  fputc('+', out);
+  for (uint8_t x = 0; x < 128; x++) fputc('-', out);
+  fputs("+\n", out);
+  for (uint8_t y = 0; y < 64; y += 2) {
+    fputc('|', out);
+    for (uint8_t x = 0; x < 128; x++) {
+      fputs(blocks[getPixel(x, y) | (getPixel(x, y + 1) << 1)], out);
+    }
+    fputs("|\n", out);
+  }
+  fputc('+', out);
+  for (uint8_t x = 0; x < 128; x++) fputc('-', out);
+  fputs("+\n", out);
+}
+
+// ============================================================================
+// DHT22
+// ============================================================================
+
+// Длительности уровней, мкс
+#define DHT_RESPONSE_DELAY  30
+#define DHT_RESPONSE_LOW    80
+#define DHT_RESPONSE_HIGH   80
+#define DHT_BIT_LOW         50
+#define DHT_BIT_HIGH_0      26
+#define DHT_BIT_HIGH_1      70
+#define DHT_MIN_START       800   // Короче датчик не замечает
+#define DHT_POWER_UP        2000000
+
+void Dht22Model::begin(uint8_t dataPin) {
+  pin = dataPin;
+  readyAt = host::now() + DHT_POWER_UP;
+  host::setExternalPullup(pin, true);   // Резистор на линии данных
+  host::observePin(pin, onPin, this);
+}
+
+void Dht22Model::set(float humidity, float temperature) {
+  humidity10 = (int16_t)lroundf(humidity * 10);
+  temperature10 = (int16_t)lroundf(temperature * 10);
+  if (humidity10 < 0) humidity10 = 0;
+  if (humidity10 > 1000) humidity10 = 1000;
+}
+
+void Dht22Model::onPin(void* context, uint8_t pin) {
+  Dht22Model* self = (Dht22Model*)context;
+  bool low = host::pinIsOutput(pin) && host::pinLevel(pin) == LOW;
+
+  if (low) {
+    if (!self->lowSince) self->lowSince = host::now();
+    return;
+  }
+  if (self->lowSince && !host::pinIsOutput(pin)) {
+    uint64_t held = host::now() - self->lowSince;
+    self->lowSince = 0;
+    if (held >= DHT_MIN_START && !self->fault && host::now() >= self->readyAt)
+      self->respond();
+  }
+}
+
+// Ответ: 80 мкс ноль, 80 мкс единица, затем 40 бит "50 мкс ноль +
+// 26/70 мкс единица" и завершающий ноль. Старший бит первым
+void Dht22Model::respond() {
+  requests++;
+  uint8_t data[5];
+  uint16_t t = temperature10 < 0 ? (uint16_t)(-temperature10) | 0x8000 : temperature10;
+  data[0] = humidity10 >> 8;
+  data[1] = humidity10 & 0xFF;
+  data[2] = t >> 8;
+  data[3] = t & 0xFF;
+  data[4] = data[0] + data[1] + data[2] + data[3];
+
+  uint64_t at = host::now() + DHT_RESPONSE_DELAY;
+  host::schedulePin(at, pin, LOW);
+  at += DHT_RESPONSE_LOW;
+  host::schedulePin(at, pin, HIGH);
+  at += DHT_RESPONSE_HIGH;
+
+  for (uint8_t i = 0; i < 40; i++) {
+    bool bit = data[i >> 3] & (0x80 >> (i & 7));
+    host::schedulePin(at, pin, LOW);
+    at += DHT_BIT_LOW;
+    host::schedulePin(at, pin, HIGH);
+    at += bit ? DHT_BIT_HIGH_1 : DHT_BIT_HIGH_0;
+  }
+
+  host::schedulePin(at, pin, LOW);
+  at += DHT_BIT_LOW;
+  host::schedulePin(at, pin, HOST_UNDRIVEN);
+}
+
+// ============================================================================
+// SHT31
+// ============================================================================
+
+#define SHT31_MEASURE_US  12500   // Высокая точность, типичное время
+
+static uint8_t sht31Crc(const uint8_t* bytes) {
+  uint8_t crc = 0xFF;
+  for (uint8_t i = 0; i < 2; i++) {
+    crc ^= bytes[i];
+    for (uint8_t b = 0; b < 8; b++) crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+  }
+  return crc;
+}
+
+void Sht31Model::set(float humidity, float temperature) {
+  float t = (temperature + 45) * 65535 / 175;
+  float h = humidity * 65535 / 100;
+  rawT = (uint16_t)lroundf(t < 0 ? 0 : t > 65535 ? 65535 : t);
+  rawH = (uint16_t)lroundf(h < 0 ? 0 : h > 65535 ? 65535 : h);
+}
+
+// Из команд понимает только одиночный замер, остальные подтверждает
+bool Sht31Model::onWrite(const uint8_t* data, uint8_t length) {
+  if (length == 2 && data[0] == 0x24 && data[1] == 0x00) {
+    readyAt = host::now() + SHT31_MEASURE_US;
+  }
+  return true;
+}
+
+uint8_t Sht31Model::onRead(uint8_t* data, uint8_t length) {
+  if (!readyAt || host::now() < readyAt || length < 6) return 0;
+  readyAt = 0;
+  data[0] = rawT >> 8;
+  data[1] = rawT & 0xFF;
+  data[2] = sht31Crc(data);
+  data[3] = rawH >> 8;
+  data[4] = rawH & 0xFF;
+  data[5] = sht31Crc(data + 3);
+  return 6;
+}
+
+// ============================================================================
+// BME280
+// ============================================================================
+
+#define BME280_MEASURE_US  6000   // T и RH x1, давление выключено
+
+// Калибровка из примера Bosch
+static const uint16_t bmeT1 = 27504;
+static const int16_t bmeT2 = 26435, bmeT3 = -1000;
+static const uint8_t bmeH1 = 75, bmeH3 = 0;
+static const int16_t bmeH2 = 370, bmeH4 = 313, bmeH5 = 50;
+static const int8_t bmeH6 = 30;
+
+// Формулы даташита: t_fine и влажность в 1/1024 %
+static int32_t bmeTFine(int32_t adcT) {
+  int32_t var1 = ((((adcT >> 3) - ((int32_t)bmeT1 << 1))) * bmeT2) >> 11;
+  int32_t var2 = (adcT >> 4) - (int32_t)bmeT1;
+  var2 = (((var2 * var2) >> 12) * bmeT3) >> 14;
+  return var1 + var2;
+}
+
+static int32_t bmeHumidity(int32_t adcH, int32_t tFine) {
+  int32_t v = tFine - 76800;
+  v = (((adcH << 14) - ((int32_t)bmeH4 << 20) - ((int32_t)bmeH5 * v) + 16384) >> 15) *
+      (((((((v * bmeH6) >> 10) * (((v * (int32_t)bmeH3) >> 11) + 32768)) >> 10) +
+         2097152) * bmeH2 + 8192) >> 14);
+  v -= ((((v >> 15) * (v >> 15)) >> 7) * (int32_t)bmeH1) >> 4;
+  if (v < 0) v = 0;
+  if (v > 419430400) v = 419430400;
+  return v >> 12;
+}
+
+Bme280Model::Bme280Model()
+  : pointer(0), readyAt(0), humidity(45.0f), temperature(22.0f) {
+  memset(regs, 0, sizeof(regs));
+  regs[0xD0] = 0x60;   // chip_id
+  regs[0x88] = bmeT1 & 0xFF; regs[0x89] = bmeT1 >> 8;
+  regs[0x8A] = bmeT2 & 0xFF; regs[0x8B] = (uint16_t)bmeT2 >> 8;
+  regs[0x8C] = bmeT3 & 0xFF; regs[0x8D] = (uint16_t)bmeT3 >> 8;
+  regs[0xA1] = bmeH1;
+  regs[0xE1] = bmeH2 & 0xFF; regs[0xE2] = bmeH2 >> 8;
+  regs[0xE3] = bmeH3;
+  regs[0xE4] = bmeH4 >> 4;
+  regs[0xE5] = (bmeH4 & 0x0F) | ((bmeH5 & 0x0F) << 4);
+  regs[0xE6] = bmeH5 >> 4;
+  regs[0xE7] = (uint8_t)bmeH6;
+  regs[0xF7] = 0x80;   // Давление не измерялось
+}
+
+// Коды АЦП - двоичным поиском по тем же формулам, что у прошивки
+void Bme280Model::measure() {
+  int32_t targetT = (int32_t)lroundf(temperature * 100);
+  int32_t lo = 0, hi = (1 << 20) - 1;
+  while (lo < hi) {
+    int32_t mid = (lo + hi) / 2;
+    if ((bmeTFine(mid) * 5 + 128) >> 8 < targetT) lo = mid + 1;
+    else hi = mid;
+  }
+  int32_t adcT = lo;
+  int32_t tFine = bmeTFine(adcT);
+
+  float h = humidity < 0 ? 0 : humidity > 100 ? 100 : humidity;
+  int32_t targetH = (int32_t)lroundf(h * 1024);
+  lo = 0;
+  hi = 65535;
+  while (lo < hi) {
+    int32_t mid = (lo + hi) / 2;
+    if (bmeHumidity(mid, tFine) < targetH) lo = mid + 1;
+    else hi = mid;
+  }
+  int32_t adcH = lo;
+
+  regs[0xFA] = adcT >> 12;
+  regs[0xFB] = (adcT >> 4) & 0xFF;
+  regs[0xFC] = (adcT & 0x0F) << 4;
+  regs[0xFD] = adcH >> 8;
+  regs[0xFE] = adcH & 0xFF;
+}
+
+void Bme280Model::writeRegister(uint8_t reg, uint8_t value) {
+  if (reg == 0xF2 || reg == 0xF5) regs[reg] = value;
+  if (reg == 0xF4) {
+    regs[reg] = value;
+    // Принудительный режим (01 или 10): один замер и снова сон
+    if (value & 0x03 && (value & 0x03) != 0x03) {
+      measure();
+      readyAt = host::now() + BME280_MEASURE_US;
+      regs[0xF4] = value & 0xFC;
+    }
+  }
+}
+
+// Пары "адрес, значение"; одиночный байт - адрес для чтения
+bool Bme280Model::onWrite(const uint8_t* data, uint8_t length) {
+  if (length == 0) return true;
+  pointer = data[0];
+  for (uint8_t i = 0; i + 1 < length; i += 2) writeRegister(data[i], data[i + 1]);
+  return true;
+}
+
+uint8_t Bme280Model::onRead(uint8_t* data, uint8_t length) {
+  for (uint8_t i = 0; i < length; i++) {
+    uint8_t reg = pointer++;
+    data[i] = regs[reg];
+    if (reg == 0xF3) data[i] = host::now() < readyAt ? 0x08 : 0x00;
+  }
+  return length;
+}
+
+// ============================================================================
+// ЭНКОДЕР
+// ============================================================================
+
+// Полный цикл на щелчок, в покое оба контакта разомкнуты (1).
+// По часовой стрелке CLK замыкается раньше DT
+void EncoderModel::turn(uint64_t at, int detents, uint32_t intervalMs) {
+  uint8_t first = detents > 0 ? clkPin : dtPin;
+  uint8_t second = detents > 0 ? dtPin : clkPin;
+  int count = detents > 0 ? detents : -detents;
+
+  for (int i = 0; i < count; i++) {
+    uint64_t t = at + (uint64_t)i * intervalMs * 1000;
+    // Полушаговый: щелчок переводит оба входа из 11 в 00 или обратно
+    if (stepsPerDetent == 2) {
+      uint8_t level = restLow ? HOST_UNDRIVEN : LOW;
+      host::schedulePin(t, first, level);
+      host::schedulePin(t + 2000, second, level);
+      restLow = !restLow;
+      continue;
+    }
+    host::schedulePin(t, first, LOW);
+    host::schedulePin(t + 2000, second, LOW);
+    host::schedulePin(t + 4000, first, HOST_UNDRIVEN);
+    host::schedulePin(t + 6000, second, HOST_UNDRIVEN);
+  }
+}
+
+void EncoderModel::press(uint64_t at, uint32_t durationMs) {
+  host::schedulePin(at, swPin, LOW);
+  host::schedulePin(at + (uint64_t)durationMs * 1000, swPin, HOST_UNDRIVEN);
+}
@@ -0,0 +1,154 @@
+/*
+ * МОДЕЛИ УСТРОЙСТВ ДЛЯ СБОРКИ НА ПК
+ * Контроллер SSD1306 и датчики SHT31/BME280 на шине I2C, датчик
+ * DHT22 на однопроводной линии и механический энкодер. Модели
+ * работают на уровне выводов и байтов шины, поэтому прошивка
+ * использует свои настоящие драйверы.
+ */
+
+#ifndef DEVICES_H
+#define DEVICES_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "host.h"
+
+// ============================================================================
+// SSD1306: команды окна/адресации и память изображения 128x64
+// ============================================================================
+
+class Ssd1306Model : public host::I2cDevice {
+private:
+  uint8_t ram[8][128];
+  uint8_t addressingMode;   // 0 - горизонтальный, 1 - вертикальный, 2 - страничный
+  uint8_t colStart, colEnd, pageStart, pageEnd;
+  uint8_t col, page;
+  uint8_t contrast;
+  bool displayOn;
+
+  // Разбор команды с аргументами, которая может прийти по частям
+  uint8_t cmd[8];
+  uint8_t cmdLength;
+  uint8_t cmdExpected;
+
+  uint32_t dataBytes;
+  uint32_t commandBytes;
+
+  void command(uint8_t byte);
+  void execute();
+  void data(uint8_t byte);
+
+public:
+  Ssd1306Model();
+
+  bool onWrite(const uint8_t* data, uint8_t length) override;
+
+  uint8_t getPixel(uint8_t x, uint8_t y) const { return (ram[y >> 3][x] >> (y & 7)) & 1; }
+  uint8_t getContrast() const { return contrast; }
+  bool isOn() const { return displayOn; }
+  uint32_t getDataBytes() const { return dataBytes; }
+  uint32_t getCommandBytes() const { return commandBytes; }
+
+  // Изображение псевдографикой: строка текста = две строки пикселей
+  void dump(FILE* out) const;
+};
+
+// ============================================================================
+// DHT22: отвечает на стартовый импульс 40 битами с нужными интервалами.
+// Первые 2 с после включения молчит, как настоящий
+// ============================================================================
+
+class Dht22Model {
+private:
+  uint8_t pin;
+  int16_t humidity10;
+  int16_t temperature10;
+  bool fault;
+  uint64_t lowSince;    // Когда прошивка прижала линию (0 - не прижата)
+  uint32_t requests;    // Ответов на стартовый импульс
+  uint64_t readyAt;     // Конец разогрева после включения
+
+  static void onPin(void* context, uint8_t pin);
+  void respond();
+
+public:
+  Dht22Model() : pin(0), humidity10(450), temperature10(220), fault(false), lowSince(0),
+                 requests(0), readyAt(0) {}
+
+  void begin(uint8_t dataPin);
+  void set(float humidity, float temperature);
+  void setFault(bool enable) { fault = enable; }  // Не отвечать на запросы
+  uint32_t getRequests() const { return requests; }
+};
+
+// ============================================================================
+// SHT31: одиночный замер по команде 0x2400, до готовности - NACK на чтение
+// ============================================================================
+
+class Sht31Model : public host::I2cDevice {
+private:
+  uint16_t rawT, rawH;   // Коды АЦП, как их отдает датчик
+  uint64_t readyAt;      // Конец замера (0 - замер не запущен)
+
+public:
+  Sht31Model() : rawT(0), rawH(0), readyAt(0) { set(45.0, 22.0); }
+
+  bool onWrite(const uint8_t* data, uint8_t length) override;
+  uint8_t onRead(uint8_t* data, uint8_t length) override;
+
+  void set(float humidity, float temperature);
+};
+
+// ============================================================================
+// BME280: регистры, принудительный режим, флаг measuring
+// ============================================================================
+
+class Bme280Model : public host::I2cDevice {
+private:
+  uint8_t regs[256];
+  uint8_t pointer;       // Адрес регистра для чтения
+  uint64_t readyAt;      // Конец замера: до него status.measuring = 1
+  float humidity, temperature;
+
+  void writeRegister(uint8_t reg, uint8_t value);
+  void measure();        // Коды АЦП для заданных значений - в регистры данных
+
+public:
+  Bme280Model();
+
+  bool onWrite(const uint8_t* data, uint8_t length) override;
+  uint8_t onRead(uint8_t* data, uint8_t length) override;
+
+  void set(float hum, float temp) { humidity = hum; temperature = temp; }
+};
+
+// ============================================================================
+// ЭНКОДЕР: повороты на щелчок и нажатия кнопки
+// ============================================================================
+
+class EncoderModel {
+private:
+  uint8_t clkPin, dtPin, swPin;
+  uint8_t stepsPerDetent;   // 2 - полцикла на щелчок, 4 - цикл
+  bool restLow;             // После запланированных щелчков оба входа = 0
+
+public:
+  EncoderModel() : clkPin(0), dtPin(0), swPin(0), stepsPerDetent(4), restLow(false) {}
+
+  void begin(uint8_t clk, uint8_t dt, uint8_t sw, uint8_t steps) {
+    clkPin = clk;
+    dtPin = dt;
+    swPin = sw;
+    stepsPerDetent = steps;
+  }
+
+  // Планирование на момент at (мкс виртуального времени).
+  // detents > 0 - по часовой стрелке
+  void turn(uint64_t at, int detents, uint32_t intervalMs = 100);
+  void press(uint64_t at, uint32_t durationMs);
+  void click(uint64_t at) { press(at, 80); }
+  void doubleClick(uint64_t at) { press(at, 80); press(at + 160000, 80); }
+};
+
+#endif // DEVICES_H
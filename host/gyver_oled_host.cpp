@@ -0,0 +1,279 @@
+/*
+ * GYVEROLED ДЛЯ СБОРКИ НА ПК: формирование трафика SSD1306
+ */
+
+#include "hal_host.h"
+
+#define OLED_CHUNK 16   // Байт данных в одной транзакции, как у GyverOLED
+
+namespace {
+
+// Шрифт 5x7, символы 0x20-0x7E
+const uint8_t font[][5] = {
+  {0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5F,0x00,0x00}, {0x00,0x07,0x00,0x07,0x00},
+  {0x14,0x7F,0x14,0x7F,0x14}, {0x24,0x2A,0x7F,0x2A,0x12}, {0x23,0x13,0x08,0x64,0x62},
+  {0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00}, {0x00,0x1C,0x22,0x41,0x00},
+  {0x00,0x41,0x22,0x1C,0x00}, {0x08,0x2A,0x1C,0x2A,0x08}, {0x08,0x08,0x3E,0x08,0x08},
+  {0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08}, {0x00,0x60,0x60,0x00,0x00},
+  {0x20,0x10,0x08,0x04,0x02}, {0x3E,0x51,0x49,0x45,0x3E}, {0x00,0x42,0x7F,0x40,0x00},
+  {0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4B,0x31}, {0x18,0x14,0x12,0x7F,0x10},
+  {0x27,0x45,0x45,0x45,0x39}, {0x3C,0x4A,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+  {0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1E}, {0x00,0x36,0x36,0x00,0x00},
+  {0x00,0x56,0x36,0x00,0x00}, {0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14},
+  {0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06}, {0x32,0x49,0x79,0x41,0x3E},
+  {0x7E,0x11,0x11,0x11,0x7E}, {0x7F,0x49,0x49,0x49,0x36}, {0x3E,0x41,0x41,0x41,0x22},
+  {0x7F,0x41,0x41,0x22,0x1C}, {0x7F,0x49,0x49,0x49,0x41}, {0x7F,0x09,0x09,0x01,0x01},
+  {0x3E,0x41,0x41,0x51,0x32}, {0x7F,0x08,0x08,0x08,0x7F}, {0x00,0x41,0x7F,0x41,0x00},
+  {0x20,0x40,0x41,0x3F,0x01}, {0x7F,0x08,0x14,0x22,0x41}, {0x7F,0x40,0x40,0x40,0x40},
+  {0x7F,0x02,0x04,0x02,0x7F}, {0x7F,0x04,0x08,0x10,0x7F}, {0x3E,0x41,0x41,0x41,0x3E},
+  {0x7F,0x09,0x09,0x09,0x06}, {0x3E,0x41,0x51,0x21,0x5E}, {0x7F,0x09,0x19,0x29,0x46},
+  {0x46,0x49,0x49,0x49,0x31}, {0x01,0x01,0x7F,0x01,0x01}, {0x3F,0x40,0x40,0x40,0x3F},
+  {0x1F,0x20,0x40,0x20,0x1F}, {0x7F,0x20,0x18,0x20,0x7F}, {0x63,0x14,0x08,0x14,0x63},
+  {0x03,0x04,0x78,0x04,0x03}, {0x61,0x51,0x49,0x45,0x43}, {0x00,0x7F,0x41,0x41,0x00},
+  {0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7F,0x00}, {0x04,0x02,0x01,0x02,0x04},
+  {0x40,0x40,0x40,0x40,0x40}, {0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78},
+  {0x7F,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20}, {0x38,0x44,0x44,0x48,0x7F},
+  {0x38,0x54,0x54,0x54,0x18}, {0x08,0x7E,0x09,0x01,0x02}, {0x08,0x14,0x54,0x54,0x3C},
+  {0x7F,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7D,0x40,0x00}, {0x20,0x40,0x44,0x3D,0x00},
+  {0x00,0x7F,0x10,0x28,0x44}, {0x00,0x41,0x7F,0x40,0x00}, {0x7C,0x04,0x18,0x04,0x78},
+  {0x7C,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38}, {0x7C,0x14,0x14,0x14,0x08},
+  {0x08,0x14,0x14,0x18,0x7C}, {0x7C,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+  {0x04,0x3F,0x44,0x40,0x20}, {0x3C,0x40,0x40,0x20,0x7C}, {0x1C,0x20,0x40,0x20,0x1C},
+  {0x3C,0x40,0x30,0x40,0x3C}, {0x44,0x28,0x10,0x28,0x44}, {0x0C,0x50,0x50,0x50,0x3C},
+  {0x44,0x64,0x54,0x4C,0x44}, {0x00,0x08,0x36,0x41,0x00}, {0x00,0x00,0x7F,0x00,0x00},
+  {0x00,0x41,0x36,0x08,0x00}, {0x08,0x04,0x08,0x10,0x08}
+};
+
+// Кириллица рисуется похожими латинскими буквами, остальное - рамкой.
+// Для отладки разметки экрана этого достаточно
+const char cyrillicLookalike[64 + 1] =
+  "A6BrDEX3NNKJMHOnPCTYoXU4WWbbbEUR"   // А-Я (0x410-0x42F)
+  "a6brdex3uukjmhonpctyoxu4wwbbbeur";  // а-я (0x430-0x44F)
+
+const uint8_t unknownGlyph[5] = {0x7F, 0x41, 0x41, 0x41, 0x7F};
+
+const uint8_t* glyphFor(uint16_t code) {
+  if (code >= 0x410 && code <= 0x44F) code = cyrillicLookalike[code - 0x410];
+  else if (code == 0x401) code = 'E';   // Ё
+  else if (code == 0x451) code = 'e';   // ё
+  if (code >= 0x20 && code <= 0x7E) return font[code - 0x20];
+  return unknownGlyph;
+}
+
+} // namespace
+
+void HostOled::beginCommand() {
+  Wire.beginTransmission(address);
+  Wire.write(0x00);
+}
+
+void HostOled::beginData() {
+  Wire.beginTransmission(address);
+  Wire.write(0x40);
+  writes = 0;
+}
+
+void HostOled::sendByte(uint8_t data) {
+  if (writes >= OLED_CHUNK) {
+    endTransm();
+    beginData();
+  }
+  Wire.write(data);
+  writes++;
+}
+
+void HostOled::endTransm() {
+  Wire.endTransmission();
+}
+
+void HostOled::setWindow(int x0, int page0, int x1, int page1) {
+  beginCommand();
+  Wire.write(0x21);
+  Wire.write(x0);
+  Wire.write(x1);
+  Wire.write(0x22);
+  Wire.write(page0);
+  Wire.write(page1);
+  endTransm();
+}
+
+void HostOled::init(uint8_t addr) {
+  static const uint8_t commands[] = {
+    0xAE, 0xD5, 0x80, 0xA8, 0x3F, 0xD3, 0x00, 0x40, 0x8D, 0x14,
+    0x20, 0x00, 0xA1, 0xC8, 0xDA, 0x12, 0x81, 0x7F, 0xD9, 0xF1,
+    0xDB, 0x40, 0xA4, 0xA6, 0xAF
+  };
+  address = addr;
+  beginCommand();
+  for (uint8_t i = 0; i < sizeof(commands); i++) Wire.write(commands[i]);
+  endTransm();
+}
+
+void HostOled::clear() {
+  clear(0, 0, 127, 63);
+}
+
+void HostOled::clear(int x0, int y0, int x1, int y1) {
+  rect(x0, y0, x1, y1, OLED_CLEAR);
+}
+
+void HostOled::setContrast(uint8_t value) {
+  beginCommand();
+  Wire.write(0x81);
+  Wire.write(value);
+  endTransm();
+}
+
+void HostOled::setPower(bool on) {
+  beginCommand();
+  Wire.write(on ? 0xAF : 0xAE);
+  endTransm();
+}
+
+// Без буфера точка пишется целым байтом столбца: остальные
+// 7 пикселей этого байта гаснут, как и на реальном дисплее
+void HostOled::dot(int x, int y, uint8_t fill) {
+  if (x < 0 || x > 127 || y < 0 || y > 63) return;
+  setWindow(x, y >> 3, x, y >> 3);
+  beginData();
+  sendByte(fill ? (1 << (y & 7)) : 0);
+  endTransm();
+}
+
+void HostOled::line(int x0, int y0, int x1, int y1, uint8_t fill) {
+  if (x0 == x1) { fastLineV(x0, y0, y1, fill); return; }
+  if (y0 == y1) { fastLineH(y0, x0, x1, fill); return; }
+
+  int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+  int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+  int sx = x0 < x1 ? 1 : -1;
+  int sy = y0 < y1 ? 1 : -1;
+  int err = dx + dy;
+  for (;;) {
+    dot(x0, y0, fill);
+    if (x0 == x1 && y0 == y1) break;
+    int e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+void HostOled::fastLineH(int y, int x0, int x1, uint8_t fill) {
+  if (y < 0 || y > 63) return;
+  if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
+  x0 = constrain(x0, 0, 127);
+  x1 = constrain(x1, 0, 127);
+  setWindow(x0, y >> 3, x1, y >> 3);
+  beginData();
+  for (int x = x0; x <= x1; x++) sendByte(fill ? (1 << (y & 7)) : 0);
+  endTransm();
+}
+
+void HostOled::fastLineV(int x, int y0, int y1, uint8_t fill) {
+  if (x < 0 || x > 127) return;
+  if (y0 > y1) { int t = y0; y0 = y1; y1 = t; }
+  y0 = constrain(y0, 0, 63);
+  y1 = constrain(y1, 0, 63);
+  setWindow(x, y0 >> 3, x, y1 >> 3);
+  beginData();
+  for (int page = y0 >> 3; page <= (y1 >> 3); page++) {
+    uint8_t bits = 0;
+    for (uint8_t b = 0; b < 8; b++) {
+      int y = (page << 3) + b;
+      if (y >= y0 && y <= y1) bits |= 1 << b;
+    }
+    sendByte(fill ? bits : 0);
+  }
+  endTransm();
+}
+
+void HostOled::rect(int x0, int y0, int x1, int y1, uint8_t fill) {
+  if (fill == OLED_STROKE) {
+    fastLineH(y0, x0, x1);
+    fastLineH(y1, x0, x1);
+    fastLineV(x0, y0, y1);
+    fastLineV(x1, y0, y1);
+    return;
+  }
+  if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
+  if (y0 > y1) { int t = y0; y0 = y1; y1 = t; }
+  x0 = constrain(x0, 0, 127);
+  x1 = constrain(x1, 0, 127);
+  y0 = constrain(y0, 0, 63);
+  y1 = constrain(y1, 0, 63);
+
+  setWindow(x0, y0 >> 3, x1, y1 >> 3);
+  beginData();
+  for (int page = y0 >> 3; page <= (y1 >> 3); page++) {
+    uint8_t bits = 0;
+    for (uint8_t b = 0; b < 8; b++) {
+      int y = (page << 3) + b;
+      if (y >= y0 && y <= y1) bits |= 1 << b;
+    }
+    for (int x = x0; x <= x1; x++) sendByte(fill == OLED_FILL ? bits : 0);
+  }
+  endTransm();
+}
+
+// Символ 6x8 (5 столбцов + промежуток), при масштабе s - 6s x 8s
+void HostOled::drawGlyph(const uint8_t* columns) {
+  int width = 6 * scale;
+  if (cursorX > 127 || cursorY > 63) {
+    cursorX += width;
+    return;
+  }
+  int x1 = cursorX + width - 1;
+  if (x1 > 127) x1 = 127;
+  int page0 = cursorY >> 3;
+  int page1 = page0 + scale - 1;
+  if (page1 > 7) page1 = 7;
+
+  setWindow(cursorX, page0, x1, page1);
+  beginData();
+  for (int page = page0; page <= page1; page++) {
+    for (int x = cursorX; x <= x1; x++) {
+      uint8_t col = (x - cursorX) / scale;
+      uint8_t src = col < 5 ? columns[col] : 0;
+      uint8_t out = 0;
+      for (uint8_t b = 0; b < 8; b++) {
+        uint8_t srcBit = ((page - page0) * 8 + b) / scale;
+        if (src & (1 << srcBit)) out |= 1 << b;
+      }
+      sendByte(invert ? ~out : out);
+    }
+  }
+  endTransm();
+  cursorX += width;
+}
+
+uint8_t HostOled::getFont(uint8_t code, uint8_t row) {
+  if (row > 4) return 0;
+  uint16_t unicode = code;
+  if (code >= 0x90 && code <= 0xBF) unicode = 0x410 + code - 0x90;
+  else if (code >= 0x80 && code <= 0x8F) unicode = 0x440 + code - 0x80;
+  return glyphFor(unicode)[row];
+}
+
+size_t HostOled::write(uint8_t c) {
+  if (c == '\r') return 1;
+  if (c == '\n') {
+    cursorX = 0;
+    cursorY += 8 * scale;
+    return 1;
+  }
+
+  // Двухбайтные последовательности UTF-8 (кириллица)
+  if (c >= 0xC0) {
+    utfPrefix = c;
+    return 1;
+  }
+  uint16_t code = c;
+  if (c >= 0x80) {
+    if (!utfPrefix) return 1;
+    code = ((uint16_t)(utfPrefix & 0x1F) << 6) | (c & 0x3F);
+    utfPrefix = 0;
+  }
+
+  drawGlyph(glyphFor(code));
+  return 1;
+}
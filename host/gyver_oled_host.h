@@ -0,0 +1,85 @@
+/*
+ * GYVEROLED ДЛЯ СБОРКИ НА ПК
+ * Подмножество API GyverOLED, которое использует Display. Байты на шину
+ * идут так же, как у библиотеки в режиме OLED_NO_BUFFER: каждая операция
+ * задает окно (0x21/0x22) и сразу пишет данные порциями по 16 байт.
+ * Изображение собирает модель контроллера SSD1306 на шине (devices.h),
+ * поэтому на ПК видно ровно то, что ушло по I2C.
+ */
+
+#ifndef GYVER_OLED_HOST_H
+#define GYVER_OLED_HOST_H
+
+#define SSD1306_128x32  0
+#define SSD1306_128x64  1
+#define SSH1106_128x64  2
+
+#define OLED_I2C        0
+#define OLED_SPI        1
+
+#define OLED_NO_BUFFER  0
+#define OLED_BUFFER     1
+
+#define OLED_CLEAR      0
+#define OLED_FILL       1
+#define OLED_STROKE     2
+
+#define BUF_ADD         0
+#define BUF_SUBTRACT    1
+#define BUF_REPLACE     2
+
+class HostOled : public Print {
+private:
+  uint8_t address;
+  int cursorX;
+  int cursorY;          // В пикселях
+  uint8_t scale;
+  bool invert;
+  uint8_t utfPrefix;    // Первый байт двухбайтного символа UTF-8
+  uint8_t writes;       // Байт в текущей порции данных
+
+  void drawGlyph(const uint8_t* columns);
+
+public:
+  HostOled() : address(0x3C), cursorX(0), cursorY(0), scale(1), invert(false),
+               utfPrefix(0), writes(0) {}
+
+  void init(uint8_t addr = 0x3C);
+  void clear();
+  void clear(int x0, int y0, int x1, int y1);
+  void update() {}  // Без буфера все уже на экране
+  void setContrast(uint8_t value);
+  void setPower(bool on);
+
+  void home() { setCursor(0, 0); }
+  void setCursor(int x, int row) { cursorX = x; cursorY = row << 3; }
+  void setCursorXY(int x, int y) { cursorX = x; cursorY = y; }
+  void setScale(uint8_t s) { scale = s < 1 ? 1 : (s > 4 ? 4 : s); }
+  void invertText(bool inv) { invert = inv; }
+  void textMode(uint8_t) {}
+
+  void dot(int x, int y, uint8_t fill = 1);
+  void line(int x0, int y0, int x1, int y1, uint8_t fill = 1);
+  void fastLineH(int y, int x0, int x1, uint8_t fill = 1);
+  void fastLineV(int x, int y0, int y1, uint8_t fill = 1);
+  void rect(int x0, int y0, int x1, int y1, uint8_t fill = 1);
+
+  // Низкий уровень, как у GyverOLED: окно в страницах и поток данных
+  void beginCommand();
+  void beginData();
+  void sendByte(uint8_t data);
+  void endTransm();
+  void setWindow(int x0, int page0, int x1, int page1);
+
+  // Столбец row (0-4) символа, как GyverOLED::getFont(): code - ASCII
+  // или второй байт UTF-8 кириллицы (0x90-0xBF - А-п, 0x80-0x8F - р-я)
+  uint8_t getFont(uint8_t code, uint8_t row);
+
+  size_t write(uint8_t c) override;
+  using Print::write;
+};
+
+template <int TYPE, int BUFF = OLED_BUFFER, int CONN = OLED_I2C>
+class GyverOLED : public HostOled {};
+
+#endif // GYVER_OLED_HOST_H
@@ -0,0 +1,544 @@
+/*
+ * HAL ДЛЯ СБОРКИ НА ПК: виртуальное время, GPIO, Serial, EEPROM, I2C
+ */
+
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "hal_host.h"
+#include "host.h"
+
+// ============================================================================
+// ВИРТУАЛЬНОЕ ВРЕМЯ И СОБЫТИЯ
+// ============================================================================
+
+namespace {
+
+struct Event {
+  uint64_t at;
+  uint64_t seq;  // Порядок постановки для событий на одно время
+  host::EventCallback callback;
+  void* context;
+  int arg;
+
+  bool operator>(const Event& other) const {
+    return at != other.at ? at > other.at : seq > other.seq;
+  }
+};
+
+std::priority_queue<Event, std::vector<Event>, std::greater<Event> > events;
+uint64_t eventSeq = 0;
+
+uint64_t nowUs = 0;
+uint64_t nextTickUs = 1000;
+bool dispatching = false;   // Внутри события/прерывания время не двигаем
+
+void (*isrTable[host::IRQ_COUNT])() = { nullptr, nullptr, nullptr };
+bool tickEnabled = false;
+
+bool wdtEnabled = false;
+uint64_t wdtTimeoutUs = 0;
+uint64_t wdtLastReset = 0;
+bool wdtExpired = false;
+
+void onTick() {
+  if (wdtEnabled && nowUs - wdtLastReset > wdtTimeoutUs) wdtExpired = true;
+  if (tickEnabled && isrTable[host::IRQ_TICK]) isrTable[host::IRQ_TICK]();
+}
+
+} // namespace
+
+namespace host {
+
+IsrRegistrar::IsrRegistrar(Irq irq, void (*isr)()) {
+  isrTable[irq] = isr;
+}
+
+uint64_t now() { return nowUs; }
+
+void advanceTo(uint64_t at) {
+  if (dispatching) {
+    if (at > nowUs) nowUs = at;
+    return;
+  }
+
+  for (;;) {
+    uint64_t next = nextTickUs;
+    bool isEvent = !events.empty() && events.top().at <= next;
+    if (isEvent) next = events.top().at;
+    if (next > at) break;
+
+    if (next > nowUs) nowUs = next;
+    dispatching = true;
+    if (isEvent) {
+      Event e = events.top();
+      events.pop();
+      e.callback(e.context, e.arg);
+    } else {
+      nextTickUs += 1000;
+      onTick();
+    }
+    dispatching = false;
+  }
+  if (at > nowUs) nowUs = at;
+}
+
+void advance(uint64_t us) { advanceTo(nowUs + us); }
+
+void schedule(uint64_t at, EventCallback callback, void* context, int arg) {
+  Event e = { at, eventSeq++, callback, context, arg };
+  events.push(e);
+}
+
+bool watchdogExpired() { return wdtExpired; }
+
+// Проход loop(), который не спал и не ждал шину, все равно занимает время
+#define HOST_LOOP_COST_US 10
+
+bool runLoop(uint64_t until, void (*loop)()) {
+  while (nowUs < until) {
+    uint64_t before = nowUs;
+    loop();
+    if (nowUs == before) advance(HOST_LOOP_COST_US);
+    if (wdtExpired) return false;
+  }
+  return true;
+}
+
+} // namespace host
+
+unsigned long millis() { return nowUs / 1000; }
+unsigned long micros() { return nowUs; }
+void delay(unsigned long ms) { host::advance((uint64_t)ms * 1000); }
+void delayMicroseconds(unsigned int us) { host::advance(us); }
+
+// Сон до ближайшего прерывания: события устройства или тика
+void sleep_cpu() {
+  uint64_t next = nextTickUs;
+  if (!events.empty() && events.top().at < next) next = events.top().at;
+  host::advanceTo(next);
+}
+
+void wdt_enable(uint8_t timeout) {
+  wdtEnabled = true;
+  wdtTimeoutUs = (16000ULL << timeout);
+  wdtLastReset = nowUs;
+}
+
+void wdt_disable() { wdtEnabled = false; }
+void wdt_reset() { wdtLastReset = nowUs; }
+
+// На ПК прерывания приходят только из advance(), запрещать нечего
+void noInterrupts() {}
+void interrupts() {}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// ============================================================================
+// GPIO
+// ============================================================================
+
+namespace {
+
+struct PinState {
+  uint8_t mode;
+  uint8_t out;          // Регистр PORT: выход или подтяжка
+  int8_t external;      // Уровень, выставленный устройством
+  bool externalPullup;
+  uint8_t level;
+  bool pinChange;       // Разрешено PCINT
+  host::PinObserver observer;
+  void* observerContext;
+};
+
+PinState pins[HOST_PIN_COUNT];
+int analogValues[HOST_PIN_COUNT];
+
+// После сброса все выводы - входы без подтяжки, внешние устройства молчат
+struct PinReset {
+  PinReset() {
+    for (uint8_t i = 0; i < HOST_PIN_COUNT; i++) pins[i].external = HOST_UNDRIVEN;
+  }
+} pinReset;
+
+struct ExtInterrupt {
+  void (*isr)();
+  int mode;
+};
+
+ExtInterrupt extInterrupts[2] = { { nullptr, 0 }, { nullptr, 0 } };
+
+uint8_t computeLevel(const PinState& p) {
+  if (p.mode == OUTPUT) return p.out;
+  if (p.external != HOST_UNDRIVEN) return p.external;
+  if (p.out || p.externalPullup) return HIGH;
+  return LOW;
+}
+
+void fireInterrupts(uint8_t pin, uint8_t level) {
+  int8_t irq = digitalPinToInterrupt(pin);
+  if (irq >= 0 && extInterrupts[irq].isr) {
+    int mode = extInterrupts[irq].mode;
+    if (mode == CHANGE || (mode == RISING && level) || (mode == FALLING && !level)) {
+      extInterrupts[irq].isr();
+    }
+  }
+  if (pins[pin].pinChange && isrTable[host::IRQ_PIN_CHANGE]) {
+    isrTable[host::IRQ_PIN_CHANGE]();
+  }
+}
+
+void updatePin(uint8_t pin, bool fromFirmware) {
+  PinState& p = pins[pin];
+  uint8_t level = computeLevel(p);
+  if (level != p.level) {
+    p.level = level;
+    fireInterrupts(pin, level);
+  }
+  if (fromFirmware && p.observer) p.observer(p.observerContext, pin);
+}
+
+} // namespace
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= HOST_PIN_COUNT) return;
+  PinState& p = pins[pin];
+  p.mode = mode == OUTPUT ? OUTPUT : INPUT;
+  if (mode == INPUT_PULLUP) p.out = HIGH;
+  else if (mode == INPUT) p.out = LOW;
+  updatePin(pin, true);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= HOST_PIN_COUNT) return;
+  pins[pin].out = value ? HIGH : LOW;
+  updatePin(pin, true);
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < HOST_PIN_COUNT ? pins[pin].level : LOW;
+}
+
+// Преобразование АЦП занимает ~112 мкс
+int analogRead(uint8_t pin) {
+  host::advance(112);
+  return pin < HOST_PIN_COUNT ? analogValues[pin] : 0;
+}
+
+void attachInterrupt(int8_t irq, void (*isr)(), int mode) {
+  if (irq < 0 || irq > 1) return;
+  extInterrupts[irq].isr = isr;
+  extInterrupts[irq].mode = mode;
+}
+
+void detachInterrupt(int8_t irq) {
+  if (irq < 0 || irq > 1) return;
+  extInterrupts[irq].isr = nullptr;
+}
+
+void halPinChangeBegin(uint8_t) {}
+
+void halPinChangeEnable(uint8_t pin, bool enable) {
+  if (pin < HOST_PIN_COUNT) pins[pin].pinChange = enable;
+}
+
+void halTickBegin() { tickEnabled = true; }
+
+namespace host {
+
+void drivePin(uint8_t pin, int8_t level) {
+  if (pin >= HOST_PIN_COUNT) return;
+  pins[pin].external = level;
+  updatePin(pin, false);
+}
+
+void setExternalPullup(uint8_t pin, bool enable) {
+  if (pin >= HOST_PIN_COUNT) return;
+  pins[pin].externalPullup = enable;
+  updatePin(pin, false);
+}
+
+uint8_t pinLevel(uint8_t pin) { return digitalRead(pin); }
+
+bool pinIsOutput(uint8_t pin) {
+  return pin < HOST_PIN_COUNT && pins[pin].mode == OUTPUT;
+}
+
+void observePin(uint8_t pin, PinObserver observer, void* context) {
+  if (pin >= HOST_PIN_COUNT) return;
+  pins[pin].observer = observer;
+  pins[pin].observerContext = context;
+}
+
+void setAnalog(uint8_t pin, int value) {
+  if (pin < HOST_PIN_COUNT) analogValues[pin] = value;
+}
+
+static void onPinEvent(void*, int arg) {
+  drivePin(arg >> 8, (int8_t)(arg & 0xFF));
+}
+
+void schedulePin(uint64_t at, uint8_t pin, int8_t level) {
+  schedule(at, onPinEvent, nullptr, (pin << 8) | (uint8_t)level);
+}
+
+} // namespace host
+
+// ============================================================================
+// PRINT
+// ============================================================================
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long n, int base) {
+  if (base == DEC && n < 0) {
+    size_t t = write((uint8_t)'-');
+    return t + printNumber((unsigned long)-n, DEC);
+  }
+  return printNumber((unsigned long)n, base);
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+  char buf[8 * sizeof(long) + 1];
+  char* s = &buf[sizeof(buf) - 1];
+  *s = '\0';
+  if (base < 2) base = 10;
+  do {
+    char c = n % base;
+    n /= base;
+    *--s = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (n);
+  return write(s);
+}
+
+size_t Print::printFloat(double n, uint8_t digits) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+// ============================================================================
+// SERIAL
+// ============================================================================
+
+HardwareSerial Serial;
+
+namespace {
+std::string serialRx;
+FILE* serialOut = stdout;
+}
+
+int HardwareSerial::available() { return serialRx.size(); }
+
+int HardwareSerial::read() {
+  if (serialRx.empty()) return -1;
+  uint8_t c = serialRx[0];
+  serialRx.erase(0, 1);
+  return c;
+}
+
+// Как у аппаратного UART: буфер передачи на 63 байта всегда свободен,
+// вывод на ПК мгновенный
+int HardwareSerial::availableForWrite() { return 63; }
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (c == '\r') return 1;
+  if (serialOut) fputc(c, serialOut);
+  return 1;
+}
+
+namespace host {
+
+void serialInput(const char* text) { serialRx += text; }
+void setSerialOutput(FILE* out) { serialOut = out; }
+
+} // namespace host
+
+// ============================================================================
+// EEPROM
+// ============================================================================
+
+EEPROMClass EEPROM;
+
+// ============================================================================
+// I2C
+// ============================================================================
+
+TwoWire Wire;
+
+namespace {
+
+host::I2cDevice* i2cDevices[128];
+host::I2cStats i2cStatsData = { 0, 0, 0 };
+uint64_t busNanos = 0;  // Накопленное, но еще не прошедшее время шины
+
+// Транзакция в статистику: 9 тактов на байт (с ACK) плюс старт
+// и стоп. Возвращает ее время, мкс
+uint64_t accountBus(uint16_t bytes, unsigned long clock) {
+  uint64_t ns = ((uint64_t)bytes * 9 + 2) * 1000000000ULL / clock;
+  i2cStatsData.transactions++;
+  i2cStatsData.bytes += bytes;
+  busNanos += ns;
+  uint64_t us = busNanos / 1000;
+  busNanos -= us * 1000;
+  i2cStatsData.busTimeUs += us;
+  return us;
+}
+
+// Wire блокирует вызывающего на все время транзакции, как на AVR
+void busTransfer(uint8_t bytes, unsigned long clock) {
+  host::advance(accountBus(bytes, clock));
+}
+
+struct TwiModel {
+  unsigned long clock;
+  uint8_t status;
+  bool addressed;      // Байт адреса уже передан
+  bool reading;        // SLA+R: data - ответ устройства
+  uint8_t address;
+  uint8_t data[256];
+  uint16_t length;     // Запись: принято байт, чтение: готово у устройства
+  uint16_t received;   // Чтение: байт отдано прошивке
+  uint8_t rx;          // Последний принятый байт (TWDR)
+};
+
+TwiModel twi = { 100000, 0, false, false, 0, {0}, 0, 0, 0 };
+
+void twiEvent(void*, int status) {
+  twi.status = status;
+  if (isrTable[host::IRQ_TWI]) isrTable[host::IRQ_TWI]();
+}
+
+// Шаг длиной bits тактов шины, по окончании - прерывание
+void twiStep(uint8_t bits, uint8_t status) {
+  uint64_t us = ((uint64_t)bits * 1000000 + twi.clock - 1) / twi.clock;
+  host::schedule(host::now() + us, twiEvent, nullptr, status);
+}
+
+} // namespace
+
+void TwoWire::beginTransmission(uint8_t address) {
+  txAddress = address & 0x7F;
+  txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data) {
+  if (txLength >= BUFFER_LENGTH) return 0;
+  txBuffer[txLength++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t size) {
+  size_t n = 0;
+  while (size-- && write(*data++)) n++;
+  return n;
+}
+
+// 0 - успех, 2 - NACK на адрес (как у Wire)
+uint8_t TwoWire::endTransmission(bool) {
+  host::I2cDevice* device = i2cDevices[txAddress];
+  if (!device) {
+    busTransfer(1, clock);
+    return 2;
+  }
+  bool ack = device->onWrite(txBuffer, txLength);
+  busTransfer(1 + txLength, clock);
+  return ack ? 0 : 3;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool) {
+  if (quantity > BUFFER_LENGTH) quantity = BUFFER_LENGTH;
+  host::I2cDevice* device = i2cDevices[address & 0x7F];
+  rxIndex = 0;
+  rxLength = device ? device->onRead(rxBuffer, quantity) : 0;
+  busTransfer(1 + rxLength, clock);
+  return rxLength;
+}
+
+void halTwiBegin(unsigned long clock) { twi.clock = clock; }
+
+// Новая транзакция после START или повторного START
+static void twiRestart() {
+  twi.addressed = false;
+  twi.reading = false;
+  twi.length = 0;
+  twi.received = 0;
+}
+
+void halTwiStart() {
+  twiRestart();
+  twiStep(1, HAL_TWI_START);
+}
+
+uint8_t halTwiStatus() { return twi.status; }
+
+void halTwiWrite(uint8_t data) {
+  if (!twi.addressed) {
+    twi.addressed = true;
+    twi.address = data >> 1;
+    host::I2cDevice* device = i2cDevices[twi.address];
+    if (data & 1) {
+      // Ответ забирается сразу: не больше буфера Wire, как у чтения через него
+      twi.reading = true;
+      twi.length = device ? device->onRead(twi.data, BUFFER_LENGTH) : 0;
+      twiStep(9, twi.length ? HAL_TWI_READ_ACK : 0x48);
+      return;
+    }
+    twiStep(9, device ? HAL_TWI_ADDR_ACK : 0x20);
+    return;
+  }
+  if (twi.length < sizeof(twi.data)) twi.data[twi.length++] = data;
+  twiStep(9, HAL_TWI_DATA_ACK);
+}
+
+// После отданных устройством байт на шине единицы (подтяжка)
+void halTwiReceive(bool ack) {
+  twi.rx = twi.received < twi.length ? twi.data[twi.received] : 0xFF;
+  twi.received++;
+  twiStep(9, ack ? HAL_TWI_RX_ACK : HAL_TWI_RX_NACK);
+}
+
+uint8_t halTwiData() { return twi.rx; }
+
+void halTwiStop(bool next) {
+  if (twi.addressed && twi.reading) {
+    accountBus(1 + twi.received, twi.clock);
+  } else if (twi.addressed) {
+    host::I2cDevice* device = i2cDevices[twi.address];
+    if (device) {
+      device->onWrite(twi.data, twi.length);
+      accountBus(1 + twi.length, twi.clock);
+    } else {
+      accountBus(1, twi.clock);
+    }
+  }
+  if (next) {
+    twiRestart();
+    twiStep(2, HAL_TWI_START);   // STOP и новый START
+  }
+}
+
+void halTwiWait() { sleep_cpu(); }
+
+namespace host {
+
+void attachI2c(uint8_t address, I2cDevice* device) {
+  i2cDevices[address & 0x7F] = device;
+}
+
+const I2cStats& i2cStats() { return i2cStatsData; }
+
+void resetI2cStats() {
+  i2cStatsData.transactions = 0;
+  i2cStatsData.bytes = 0;
+  i2cStatsData.busTimeUs = 0;
+}
+
+} // namespace host
@@ -0,0 +1,315 @@
+/*
+ * HAL ДЛЯ СБОРКИ НА ПК
+ * Подмножество API Arduino/avr-libc, которое использует прошивка,
+ * поверх виртуального времени. Время идет только в delay(),
+ * sleep_cpu() и обмене по I2C, поэтому прогон не зависит от
+ * скорости ПК. События устройств (фронты DHT22, энкодер) и тик
+ * 1 мс выполняются как прерывания в свой момент виртуального времени.
+ *
+ * Как и в Arduino.h, min/max/abs/constrain - макросы: стандартные
+ * заголовки C++ подключать до этого файла.
+ */
+
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH          1
+#define LOW           0
+
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+
+#define CHANGE        1
+#define FALLING       2
+#define RISING        3
+
+#define DEC           10
+#define HEX           16
+#define BIN           2
+
+// Нумерация как у Nano: D0-D13, A0-A7
+#define A0            14
+#define A1            15
+#define A2            16
+#define A3            17
+#define A4            18
+#define A5            19
+#define A6            20
+#define A7            21
+#define HOST_PIN_COUNT 22
+
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+
+// ============================================================================
+// FLASH-СТРОКИ (на ПК - обычная память)
+// ============================================================================
+
+#define PROGMEM
+#define PSTR(s)               (s)
+#define pgm_read_byte(addr)   (*(const uint8_t*)(addr))
+#define pgm_read_word(addr)   (*(const uint16_t*)(addr))
+#define pgm_read_ptr(addr)    (*(const void* const*)(addr))
+#define vsnprintf_P           vsnprintf
+#define snprintf_P            snprintf
+#define strlen_P              strlen
+#define strcpy_P              strcpy
+#define strncpy_P             strncpy
+#define memcpy_P              memcpy
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+#define _BV(bit) (1 << (bit))
+
+// ============================================================================
+// ВРЕМЯ, GPIO, АЦП, ПРЕРЫВАНИЯ
+// ============================================================================
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+void attachInterrupt(int8_t irq, void (*isr)(), int mode);
+void detachInterrupt(int8_t irq);
+void noInterrupts();
+void interrupts();
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+// ============================================================================
+// WATCHDOG И СОН
+// ============================================================================
+
+#define WDTO_15MS   0
+#define WDTO_30MS   1
+#define WDTO_60MS   2
+#define WDTO_120MS  3
+#define WDTO_250MS  4
+#define WDTO_500MS  5
+#define WDTO_1S     6
+#define WDTO_2S     7
+#define WDTO_4S     8
+#define WDTO_8S     9
+
+void wdt_enable(uint8_t timeout);
+void wdt_disable();
+void wdt_reset();
+
+#define SLEEP_MODE_IDLE 0
+
+inline void set_sleep_mode(uint8_t) {}
+inline void sleep_enable() {}
+inline void sleep_disable() {}
+void sleep_cpu();
+
+inline void power_spi_disable() {}
+inline void power_timer1_disable() {}
+inline void power_timer2_disable() {}
+
+// ============================================================================
+// ПРЕРЫВАНИЯ HAL (см. hal.h)
+// ============================================================================
+
+namespace host {
+  enum Irq {
+    IRQ_PIN_CHANGE = 0,
+    IRQ_TICK = 1,
+    IRQ_TWI = 2,
+    IRQ_COUNT = 3
+  };
+
+  // Регистрация обработчика статическим объектом в единице трансляции скетча
+  struct IsrRegistrar {
+    IsrRegistrar(Irq irq, void (*isr)());
+  };
+}
+
+#define HAL_ISR_PIN_CHANGE() \
+  static void halIsrPinChange(); \
+  static host::IsrRegistrar halIsrPinChangeReg(host::IRQ_PIN_CHANGE, halIsrPinChange); \
+  static void halIsrPinChange()
+
+#define HAL_ISR_TICK() \
+  static void halIsrTick(); \
+  static host::IsrRegistrar halIsrTickReg(host::IRQ_TICK, halIsrTick); \
+  static void halIsrTick()
+
+#define HAL_ISR_TWI() \
+  static void halIsrTwi(); \
+  static host::IsrRegistrar halIsrTwiReg(host::IRQ_TWI, halIsrTwi); \
+  static void halIsrTwi()
+
+void halPinChangeBegin(uint8_t pin);
+void halPinChangeEnable(uint8_t pin, bool enable);
+void halTickBegin();
+
+// ============================================================================
+// PRINT, SERIAL
+// ============================================================================
+
+class Print {
+private:
+  size_t printNumber(unsigned long n, uint8_t base);
+  size_t printFloat(double n, uint8_t digits);
+
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  virtual size_t write(const uint8_t* buffer, size_t size);
+
+  size_t print(const __FlashStringHelper* s) { return write((const char*)s); }
+  size_t print(const char* s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); }
+  size_t print(double n, int digits = 2) { return printFloat(n, digits); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+  template <typename T> size_t println(T value, int arg) { size_t n = print(value, arg); return n + println(); }
+};
+
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  int available();
+  int read();
+  int availableForWrite();
+  size_t write(uint8_t c) override;
+  using Print::write;
+  operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// ============================================================================
+// EEPROM (1 КБ, как у ATmega328P)
+// ============================================================================
+
+#define HOST_EEPROM_SIZE 1024
+
+class EEPROMClass {
+public:
+  uint8_t data[HOST_EEPROM_SIZE];
+
+  EEPROMClass() { memset(data, 0xFF, sizeof(data)); }
+
+  uint8_t read(int addr) const { return data[addr & (HOST_EEPROM_SIZE - 1)]; }
+  void write(int addr, uint8_t value) { data[addr & (HOST_EEPROM_SIZE - 1)] = value; }
+  void update(int addr, uint8_t value) { write(addr, value); }
+  uint16_t length() const { return HOST_EEPROM_SIZE; }
+
+  template <typename T> T& get(int addr, T& value) const {
+    memcpy(&value, &data[addr], sizeof(T));
+    return value;
+  }
+
+  template <typename T> const T& put(int addr, const T& value) {
+    memcpy(&data[addr], &value, sizeof(T));
+    return value;
+  }
+};
+
+extern EEPROMClass EEPROM;
+
+// ============================================================================
+// I2C (WIRE)
+// ============================================================================
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+private:
+  uint8_t txAddress;
+  uint8_t txBuffer[BUFFER_LENGTH];
+  uint8_t txLength;
+  uint8_t rxBuffer[BUFFER_LENGTH];
+  uint8_t rxLength;
+  uint8_t rxIndex;
+  unsigned long clock;
+
+public:
+  TwoWire() : txAddress(0), txLength(0), rxLength(0), rxIndex(0), clock(100000) {}
+
+  void begin() {}
+  void setClock(unsigned long hz) { clock = hz; }
+  unsigned long getClock() const { return clock; }
+
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t data);
+  size_t write(const uint8_t* data, size_t size);
+  uint8_t endTransmission(bool stop = true);
+
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, bool stop = true);
+  int available() { return rxLength - rxIndex; }
+  int read() { return rxIndex < rxLength ? rxBuffer[rxIndex++] : -1; }
+};
+
+extern TwoWire Wire;
+
+// Модель TWI ATmega328P в режиме ведущего передатчика и приемника:
+// каждый шаг занимает свое время шины и заканчивается прерыванием
+// IRQ_TWI. Устройство получает запись целиком при STOP, а чтение
+// отдает сразу на SLA+R (0 байт - NACK на адрес)
+#define HAL_TWI_START     0x08
+#define HAL_TWI_ADDR_ACK  0x18
+#define HAL_TWI_DATA_ACK  0x28
+#define HAL_TWI_READ_ACK  0x40
+#define HAL_TWI_RX_ACK    0x50
+#define HAL_TWI_RX_NACK   0x58
+
+void halTwiBegin(unsigned long clock);
+void halTwiStart();
+uint8_t halTwiStatus();
+void halTwiWrite(uint8_t data);
+void halTwiReceive(bool ack);
+uint8_t halTwiData();
+void halTwiStop(bool next);
+void halTwiWait();   // Время идет до ближайшего события
+
+// ============================================================================
+// ПАМЯТЬ
+// ============================================================================
+
+// Раскладка SRAM Nano на ПК не моделируется: границы нулевые,
+// отчет памяти показывает только размеры объектов (sizeof хоста)
+inline uint16_t halStaticBytes() { return 0; }
+inline uint16_t halHeapEnd() { return 0; }
+inline uint16_t halStackPointer() { return 0; }
+inline uint16_t halRamTop() { return 0; }
+inline uint16_t halStackUntouched() { return 0; }
+
+// ============================================================================
+// ДИСПЛЕЙ
+// ============================================================================
+
+#include "gyver_oled_host.h"
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define abs(x) ((x) > 0 ? (x) : -(x))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#endif // HAL_HOST_H
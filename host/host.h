@@ -0,0 +1,86 @@
+/*
+ * УПРАВЛЕНИЕ ЭМУЛЯЦИЕЙ НА ПК
+ * Виртуальное время, внешние уровни на выводах, АЦП, I2C-устройства.
+ * Используется моделями устройств и программой прогона, не прошивкой.
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+namespace host {
+
+// ============================================================================
+// ВИРТУАЛЬНОЕ ВРЕМЯ
+// ============================================================================
+
+typedef void (*EventCallback)(void* context, int arg);
+
+uint64_t now();                        // Текущее время, мкс
+void advance(uint64_t us);             // Продвинуть время с выполнением событий
+void advanceTo(uint64_t at);
+void schedule(uint64_t at, EventCallback callback, void* context, int arg = 0);
+
+// Сработал ли watchdog (прошивка перестала его сбрасывать)
+bool watchdogExpired();
+
+// Вызывать loop() до момента until. false - сработал watchdog
+bool runLoop(uint64_t until, void (*loop)());
+
+// ============================================================================
+// ВЫВОДЫ
+// ============================================================================
+
+#define HOST_UNDRIVEN -1
+
+// Внешний уровень на выводе: LOW, HIGH или HOST_UNDRIVEN
+void drivePin(uint8_t pin, int8_t level);
+// Внешний подтягивающий резистор (уровень линии, которую никто не ведет)
+void setExternalPullup(uint8_t pin, bool enable);
+uint8_t pinLevel(uint8_t pin);
+bool pinIsOutput(uint8_t pin);
+
+// Прошивка изменила режим или выходной уровень вывода
+typedef void (*PinObserver)(void* context, uint8_t pin);
+void observePin(uint8_t pin, PinObserver observer, void* context);
+
+// Отложенное drivePin()
+void schedulePin(uint64_t at, uint8_t pin, int8_t level);
+
+void setAnalog(uint8_t pin, int value);
+
+// ============================================================================
+// SERIAL
+// ============================================================================
+
+void serialInput(const char* text);
+void setSerialOutput(FILE* out);
+
+// ============================================================================
+// I2C
+// ============================================================================
+
+class I2cDevice {
+public:
+  virtual ~I2cDevice() {}
+  // false - NACK
+  virtual bool onWrite(const uint8_t* data, uint8_t length) = 0;
+  virtual uint8_t onRead(uint8_t* data, uint8_t length) { (void)data; (void)length; return 0; }
+};
+
+void attachI2c(uint8_t address, I2cDevice* device);
+
+struct I2cStats {
+  uint32_t transactions;
+  uint32_t bytes;          // Включая байт адреса
+  uint64_t busTimeUs;
+};
+
+const I2cStats& i2cStats();
+void resetI2cStats();
+
+} // namespace host
+
+#endif // HOST_H
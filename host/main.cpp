@@ -0,0 +1,157 @@
+/*
+ * ПРОГОН ПРОШИВКИ НА ПК
+ * setup() и loop() скетча в виртуальном времени с моделями DHT22,
+ * SHT31, BME280, энкодера, датчика воды и дисплея.
+ *
+ *   humidifier_host [-t сек] [-T °C] [-H %] [-w АЦП] [-e файл]
+ *                   [-c команды] [-a команды] [-k клавиши] [-K мс] [-s]
+ *
+ *   -t  длительность прогона, с виртуального времени (60)
+ *   -T  температура, °C (22.0)
+ *   -H  влажность, % (45.0)
+ *   -w  показание датчика воды, 0-1023 (600)
+ *   -e  образ EEPROM: читается при старте, записывается в конце
+ *   -c  команды Serial после setup(), например "dp"
+ *   -a  команды Serial в конце прогона, еще 10 с после них
+ *   -k  действия энкодера раз в секунду после setup():
+ *       r/l - поворот, c - клик, d - двойной клик, h - удержание
+ *   -K  шаг между действиями -k, мс (1000)
+ *   -s  вывести экран в конце
+ *
+ * Код возврата: 3 - сброс по watchdog, 4 - список операций холста
+ * переполнялся (часть экрана не нарисована)
+ */
+
+#include <string>
+
+#include "../config.h"
+#include "devices.h"
+#include "host.h"
+
+void setup();
+void loop();
+uint16_t canvasOverflows();
+
+static Ssd1306Model oledModel;
+static Dht22Model dhtModel;
+static Dht22Model dht2Model;   // Второй DHT22, если задан DHT2_PIN
+static Sht31Model shtModel;
+static Bme280Model bmeModel;
+static EncoderModel encoderModel;
+
+static void usage() {
+  fprintf(stderr, "usage: humidifier_host [-t sec] [-T temp] [-H hum] [-w adc] "
+                  "[-e eeprom.bin] [-c serial] [-a serial] [-k keys] [-K ms] [-s]\n");
+}
+
+static bool loadEeprom(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  size_t n = fread(EEPROM.data, 1, sizeof(EEPROM.data), f);
+  fclose(f);
+  return n == sizeof(EEPROM.data);
+}
+
+static void saveEeprom(const char* path) {
+  FILE* f = fopen(path, "wb");
+  if (!f) {
+    fprintf(stderr, "cannot write %s\n", path);
+    return;
+  }
+  fwrite(EEPROM.data, 1, sizeof(EEPROM.data), f);
+  fclose(f);
+}
+
+static void scheduleKeys(const char* keys, uint64_t stepUs) {
+  uint64_t at = host::now() + 1000000;
+  for (const char* k = keys; *k; k++, at += stepUs) {
+    switch (*k) {
+      case 'r': encoderModel.turn(at, 1); break;
+      case 'l': encoderModel.turn(at, -1); break;
+      case 'c': encoderModel.click(at); break;
+      case 'd': encoderModel.doubleClick(at); break;
+      case 'h': encoderModel.press(at, LONG_PRESS_TIME + 200); break;
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  double seconds = 60;
+  float temperature = 22.0;
+  float humidity = 45.0;
+  int water = 600;
+  const char* eepromPath = nullptr;
+  const char* serialCommands = nullptr;
+  const char* afterCommands = nullptr;
+  const char* keys = nullptr;
+  double keyStepMs = 1000;
+  bool showScreen = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "-t" && hasValue) seconds = atof(argv[++i]);
+    else if (arg == "-T" && hasValue) temperature = atof(argv[++i]);
+    else if (arg == "-H" && hasValue) humidity = atof(argv[++i]);
+    else if (arg == "-w" && hasValue) water = atoi(argv[++i]);
+    else if (arg == "-e" && hasValue) eepromPath = argv[++i];
+    else if (arg == "-c" && hasValue) serialCommands = argv[++i];
+    else if (arg == "-a" && hasValue) afterCommands = argv[++i];
+    else if (arg == "-k" && hasValue) keys = argv[++i];
+    else if (arg == "-K" && hasValue) keyStepMs = atof(argv[++i]);
+    else if (arg == "-s") showScreen = true;
+    else {
+      usage();
+      return 2;
+    }
+  }
+
+  if (eepromPath) loadEeprom(eepromPath);
+
+  host::attachI2c(OLED_ADDRESS, &oledModel);
+  dhtModel.begin(DHT_PIN);
+  dhtModel.set(humidity, temperature);
+  if (DHT2_PIN) {
+    dht2Model.begin(DHT2_PIN);
+    dht2Model.set(humidity, temperature);
+  }
+  // Все датчики сразу: прошивка опрашивает включенные в config.h
+  host::attachI2c(SHT31_ADDRESS, &shtModel);
+  shtModel.set(humidity, temperature);
+  host::attachI2c(BME280_ADDRESS, &bmeModel);
+  bmeModel.set(humidity, temperature);
+  encoderModel.begin(ENCODER_CLK, ENCODER_DT, ENCODER_SW, ENCODER_STEPS_PER_DETENT);
+  host::setAnalog(WATER_LEVEL_PIN, water);
+
+  setup();
+
+  if (serialCommands) host::serialInput(serialCommands);
+  if (keys) scheduleKeys(keys, (uint64_t)(keyStepMs * 1000));
+
+  bool alive = host::runLoop(host::now() + (uint64_t)(seconds * 1000000), loop);
+  // Команды в конце прогона: диагностика за весь прогон
+  if (alive && afterCommands) {
+    host::serialInput(afterCommands);
+    alive = host::runLoop(host::now() + 10000000, loop);
+  }
+  if (!alive) {
+    fflush(stdout);
+    fprintf(stderr, "watchdog reset at %llu ms\n", (unsigned long long)(host::now() / 1000));
+    return 3;
+  }
+
+  fflush(stdout);
+  if (showScreen) oledModel.dump(stdout);
+
+  const host::I2cStats& bus = host::i2cStats();
+  fprintf(stderr, "virtual %.1f s, I2C %u transactions, %u bytes, %llu ms on bus\n",
+          host::now() / 1e6, bus.transactions, bus.bytes,
+          (unsigned long long)(bus.busTimeUs / 1000));
+
+  if (eepromPath) saveEeprom(eepromPath);
+  if (canvasOverflows()) {
+    fprintf(stderr, "canvas overflow in %u frames\n", canvasOverflows());
+    return 4;
+  }
+  return 0;
+}
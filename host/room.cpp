@@ -0,0 +1,74 @@
+/*
+ * МОДЕЛЬ КОМНАТЫ ДЛЯ СИМУЛЯТОРА
+ */
+
+#include <math.h>
+
+#include "room.h"
+
+RoomParams defaultRoomParams() {
+  RoomParams p;
+  p.volume = 40;
+  p.airChanges = 0.5;
+  p.windowAirChanges = 15;
+  p.outdoorTemp = -5;
+  p.outdoorHumidity = 85;
+  p.indoorTemp = 22;
+  p.tempSwing = 1;
+  p.heatingTau = 1800;
+  p.initialHumidity = 35;
+  p.humidifierRate = 300;
+  p.tankCapacity = 4000;
+  return p;
+}
+
+// Давление насыщенного пара (гПа) -> г/м³: 216.7 * e / (273.15 + T)
+float absoluteHumidity(float temp, float rh) {
+  float saturation = 6.112f * expf(17.62f * temp / (243.12f + temp));
+  return 216.7f * saturation * rh / 100.0f / (273.15f + temp);
+}
+
+float relativeHumidity(float temp, float absHum) {
+  return absHum / absoluteHumidity(temp, 100.0f) * 100.0f;
+}
+
+RoomModel::RoomModel(const RoomParams& p)
+  : params(p), temp(p.indoorTemp), waterUsed(0), windowOpen(false) {
+  absHum = absoluteHumidity(temp, p.initialHumidity);
+}
+
+void RoomModel::step(float dt, float time, bool humidifierOn) {
+  float exchange = (windowOpen ? params.windowAirChanges : params.airChanges) / 3600.0f;
+  float extraExchange = exchange - params.airChanges / 3600.0f;
+
+  // Температура: отопление к суточной кривой. Обычные потери оно
+  // покрывает, остывает комната только от проветривания. Стены и
+  // мебель держат тепло, поэтому проветривание действует слабее
+  float target = params.indoorTemp + params.tempSwing * sinf(2 * (float)M_PI * time / 86400.0f);
+  temp += ((target - temp) / params.heatingTau
+           + (params.outdoorTemp - temp) * extraExchange * 0.2f) * dt;
+
+  // Влажность: обмен с улицей и выход увлажнителя
+  float outdoorAbs = absoluteHumidity(params.outdoorTemp, params.outdoorHumidity);
+  absHum += (outdoorAbs - absHum) * exchange * dt;
+
+  if (humidifierOn && !isTankEmpty()) {
+    float grams = params.humidifierRate / 3600.0f * dt;
+    absHum += grams / params.volume;
+    waterUsed += grams;  // 1 г = 1 мл
+  }
+
+  // Выше 100% вода конденсируется
+  float saturation = absoluteHumidity(temp, 100.0f);
+  if (absHum > saturation) absHum = saturation;
+}
+
+bool RoomModel::isTankEmpty() const {
+  return params.tankCapacity > 0 && waterUsed >= params.tankCapacity;
+}
+
+float RoomModel::getTankLevel() const {
+  if (params.tankCapacity <= 0) return 1.0f;
+  float level = 1.0f - waterUsed / params.tankCapacity;
+  return level < 0 ? 0 : level;
+}
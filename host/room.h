@@ -0,0 +1,64 @@
+/*
+ * МОДЕЛЬ КОМНАТЫ ДЛЯ СИМУЛЯТОРА
+ * Абсолютная влажность воздуха (г/м³) и температура с шагом 1 с:
+ *   - обмен с улицей: ach смен воздуха в час, при открытом окне больше;
+ *   - увлажнитель добавляет rate г/ч, пока включен;
+ *   - отопление тянет температуру к суточной синусоиде,
+ *     открытое окно - к уличной;
+ *   - бак с водой расходуется увлажнителем.
+ * Относительная влажность считается по формуле Магнуса.
+ */
+
+#ifndef ROOM_H
+#define ROOM_H
+
+#include <stdint.h>
+
+struct RoomParams {
+  float volume;           // Объем, м³
+  float airChanges;       // Смен воздуха в час при закрытом окне
+  float windowAirChanges; // ... при открытом окне
+  float outdoorTemp;      // °C
+  float outdoorHumidity;  // %
+  float indoorTemp;       // Средняя температура отопления, °C
+  float tempSwing;        // Суточное колебание, ±°C
+  float heatingTau;       // Постоянная времени отопления, с
+  float initialHumidity;  // %
+  float humidifierRate;   // Производительность увлажнителя, г/ч
+  float tankCapacity;     // Объем бака, мл (0 - бесконечный)
+};
+
+// Параметры по умолчанию: спальня 15 м² зимой
+RoomParams defaultRoomParams();
+
+// Формула Магнуса: абсолютная влажность при данной температуре и RH
+float absoluteHumidity(float temp, float rh);
+float relativeHumidity(float temp, float absHum);
+
+class RoomModel {
+private:
+  RoomParams params;
+  float temp;
+  float absHum;
+  float waterUsed;        // мл
+  bool windowOpen;
+
+public:
+  explicit RoomModel(const RoomParams& p);
+
+  // Шаг интегрирования dt секунд в момент time (с от начала суток)
+  void step(float dt, float time, bool humidifierOn);
+
+  void setWindowOpen(bool open) { windowOpen = open; }
+  bool isWindowOpen() const { return windowOpen; }
+
+  float getTemperature() const { return temp; }
+  float getHumidity() const { return relativeHumidity(temp, absHum); }
+  float getAbsoluteHumidity() const { return absHum; }
+  float getWaterUsed() const { return waterUsed; }
+  bool isTankEmpty() const;
+  // Доля воды в баке, 0..1
+  float getTankLevel() const;
+};
+
+#endif // ROOM_H
@@ -0,0 +1,282 @@
+/*
+ * СИМУЛЯТОР КОМНАТЫ
+ * Настоящие setup()/loop() в виртуальном времени против модели
+ * комнаты (room.h): сутки прогоняются примерно за секунду. Модель
+ * отдает температуру и влажность датчикам (DHT22, SHT31, BME280 -
+ * какие включены в config.h) и уровень бака датчику воды, а
+ * состояние увлажнителя берет с вывода HUMIDIFIER_PIN.
+ *
+ *   humidifier_sim [--hours 24] [--csv файл] [--csv-step 60] ...
+ *
+ * Параметры комнаты - см. usage(). Итог прогона печатается в stdout:
+ * переключения в час, доля времени в диапазоне уставок, перелет,
+ * расход воды.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../config.h"
+#include "../storage.h"
+#include "../analytics.h"
+#include "devices.h"
+#include "host.h"
+#include "room.h"
+
+void setup();
+void loop();
+
+extern Storage storage;
+extern Analytics analytics;
+
+#define SIM_STEP_US 1000000UL   // Шаг модели комнаты, 1 с
+
+struct WindowEvent {
+  float start;      // с от начала прогона
+  float duration;   // с
+};
+
+struct SimStats {
+  uint32_t switches;
+  uint32_t switchesThisHour;
+  uint32_t maxSwitchesPerHour;
+  uint32_t seconds;
+  uint32_t inBand;
+  uint32_t below;
+  uint32_t above;
+  uint32_t running;
+  float maxOvershoot;
+  float maxUndershoot;
+};
+
+static Ssd1306Model oledModel;
+static Dht22Model dhtModel;
+static Dht22Model dht2Model;   // Второй DHT22, если задан DHT2_PIN
+static Sht31Model shtModel;
+static Bme280Model bmeModel;
+
+static RoomModel* room;
+static std::vector<WindowEvent> windows;
+static std::mt19937 rng;
+static std::normal_distribution<float> noise(0.0f, 0.0f);
+static float sensorHumidity;
+
+static FILE* csv = nullptr;
+static uint32_t csvStep = 60;
+
+static SimStats stats;
+static bool lastPin = false;
+
+static void usage() {
+  fputs(
+    "usage: humidifier_sim [options]\n"
+    "  --hours H          run length (24)\n"
+    "  --csv FILE         time series, '-' for stdout\n"
+    "  --csv-step S       seconds between rows (60)\n"
+    "  --min P --max P    humidity setpoints written to Storage\n"
+    "  --volume M3        room volume (40)\n"
+    "  --ach N            air changes per hour, window closed (0.5)\n"
+    "  --window-ach N     air changes per hour, window open (15)\n"
+    "  --window MIN:DUR   open window at minute MIN for DUR minutes (repeatable)\n"
+    "  --out-temp C       outdoor temperature (-5)\n"
+    "  --out-rh P         outdoor humidity (85)\n"
+    "  --temp C           heating setpoint (22)\n"
+    "  --swing C          daily temperature swing, +/- (1)\n"
+    "  --rh0 P            initial humidity (35)\n"
+    "  --rate G           humidifier output, g/h (300)\n"
+    "  --tank ML          tank capacity, 0 = unlimited (4000)\n"
+    "  --noise P          sensor humidity noise, sigma in % (0)\n"
+    "  --seed N           noise seed (1)\n"
+    "  --log              firmware Serial output to stderr\n", stderr);
+}
+
+// Щуп воды: пустой бак - WATER_LEVEL_EMPTY, полный - WATER_LEVEL_FULL
+static int waterAdc(float level) {
+  return WATER_LEVEL_EMPTY + (int)((WATER_LEVEL_FULL - WATER_LEVEL_EMPTY) * level);
+}
+
+static void onHumidifierPin(void*, uint8_t pin) {
+  bool on = host::pinLevel(pin);
+  if (on && !lastPin) {
+    stats.switches++;
+    stats.switchesThisHour++;
+  }
+  lastPin = on;
+}
+
+static void writeCsvRow(float t) {
+  fprintf(csv, "%.0f,%.2f,%.2f,%.2f,%.3f,%d,%d,%d,%.0f\n",
+          t, room->getTemperature(), room->getHumidity(), sensorHumidity,
+          room->getAbsoluteHumidity(), lastPin ? 1 : 0,
+          room->isWindowOpen() ? 1 : 0, analytics.isWindowOpen() ? 1 : 0,
+          room->getWaterUsed());
+}
+
+static void onStep(void*, int) {
+  float t = host::now() / 1e6f;
+
+  bool open = false;
+  for (size_t i = 0; i < windows.size(); i++) {
+    if (t >= windows[i].start && t < windows[i].start + windows[i].duration) open = true;
+  }
+  room->setWindowOpen(open);
+  room->step(SIM_STEP_US / 1e6f, t, lastPin);
+
+  sensorHumidity = room->getHumidity() + noise(rng);
+  dhtModel.set(sensorHumidity, room->getTemperature());
+  dht2Model.set(sensorHumidity, room->getTemperature());
+  shtModel.set(sensorHumidity, room->getTemperature());
+  bmeModel.set(sensorHumidity, room->getTemperature());
+  host::setAnalog(WATER_LEVEL_PIN, waterAdc(room->getTankLevel()));
+
+  // Статистика по истинной влажности в комнате
+  float rh = room->getHumidity();
+  float minHum = storage.getMinHumidity();
+  float maxHum = storage.getMaxHumidity();
+  stats.seconds++;
+  if (rh < minHum) {
+    stats.below++;
+    if (minHum - rh > stats.maxUndershoot) stats.maxUndershoot = minHum - rh;
+  } else if (rh > maxHum) {
+    stats.above++;
+    if (rh - maxHum > stats.maxOvershoot) stats.maxOvershoot = rh - maxHum;
+  } else {
+    stats.inBand++;
+  }
+  if (lastPin) stats.running++;
+
+  if (stats.seconds % 3600 == 0) {
+    if (stats.switchesThisHour > stats.maxSwitchesPerHour) {
+      stats.maxSwitchesPerHour = stats.switchesThisHour;
+    }
+    stats.switchesThisHour = 0;
+  }
+
+  if (csv && stats.seconds % csvStep == 0) writeCsvRow(t);
+
+  host::schedule(host::now() + SIM_STEP_US, onStep, nullptr);
+}
+
+static void printSummary(FILE* out, float hours) {
+  float total = stats.seconds ? stats.seconds : 1;
+  if (stats.switchesThisHour > stats.maxSwitchesPerHour) {
+    stats.maxSwitchesPerHour = stats.switchesThisHour;
+  }
+
+  fprintf(out, "hours              %.2f\n", hours);
+  fprintf(out, "setpoints          %u..%u %%\n", storage.getMinHumidity(), storage.getMaxHumidity());
+  fprintf(out, "switches           %u\n", stats.switches);
+  fprintf(out, "switches_per_hour  %.2f (max %u, limit %d)\n",
+          stats.switches / hours, stats.maxSwitchesPerHour, MAX_SWITCHES_PER_HOUR);
+  fprintf(out, "time_in_band       %.1f %%\n", stats.inBand * 100 / total);
+  fprintf(out, "time_below         %.1f %%\n", stats.below * 100 / total);
+  fprintf(out, "time_above         %.1f %%\n", stats.above * 100 / total);
+  fprintf(out, "overshoot_max      %.2f %%RH\n", stats.maxOvershoot);
+  fprintf(out, "undershoot_max     %.2f %%RH\n", stats.maxUndershoot);
+  fprintf(out, "duty               %.1f %%\n", stats.running * 100 / total);
+  fprintf(out, "water_used         %.0f ml\n", room->getWaterUsed());
+  fprintf(out, "sensor_reads       %u\n", (unsigned)dhtModel.getRequests());
+  fprintf(out, "final              %.1f C, %.1f %%\n", room->getTemperature(), room->getHumidity());
+}
+
+static bool parseWindow(const char* text, WindowEvent& w) {
+  float start, duration;
+  if (sscanf(text, "%f:%f", &start, &duration) != 2) return false;
+  w.start = start * 60;
+  w.duration = duration * 60;
+  return true;
+}
+
+int main(int argc, char** argv) {
+  RoomParams params = defaultRoomParams();
+  float hours = 24;
+  int minHum = -1, maxHum = -1;
+  float noiseSigma = 0;
+  unsigned seed = 1;
+  bool log = false;
+  const char* csvPath = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    bool used = true;
+
+    if (arg == "--log") { log = true; continue; }
+    if (!value) { usage(); return 2; }
+
+    if (arg == "--hours") hours = atof(value);
+    else if (arg == "--csv") csvPath = value;
+    else if (arg == "--csv-step") csvStep = atoi(value) > 0 ? atoi(value) : 1;
+    else if (arg == "--min") minHum = atoi(value);
+    else if (arg == "--max") maxHum = atoi(value);
+    else if (arg == "--volume") params.volume = atof(value);
+    else if (arg == "--ach") params.airChanges = atof(value);
+    else if (arg == "--window-ach") params.windowAirChanges = atof(value);
+    else if (arg == "--out-temp") params.outdoorTemp = atof(value);
+    else if (arg == "--out-rh") params.outdoorHumidity = atof(value);
+    else if (arg == "--temp") params.indoorTemp = atof(value);
+    else if (arg == "--swing") params.tempSwing = atof(value);
+    else if (arg == "--rh0") params.initialHumidity = atof(value);
+    else if (arg == "--rate") params.humidifierRate = atof(value);
+    else if (arg == "--tank") params.tankCapacity = atof(value);
+    else if (arg == "--noise") noiseSigma = atof(value);
+    else if (arg == "--seed") seed = atoi(value);
+    else if (arg == "--window") {
+      WindowEvent w;
+      if (!parseWindow(value, w)) { usage(); return 2; }
+      windows.push_back(w);
+    }
+    else used = false;
+
+    if (!used) { usage(); return 2; }
+    i++;
+  }
+
+  RoomModel model(params);
+  room = &model;
+  rng.seed(seed);
+  noise = std::normal_distribution<float>(0.0f, noiseSigma);
+  sensorHumidity = model.getHumidity();
+
+  if (csvPath) {
+    csv = strcmp(csvPath, "-") == 0 ? stdout : fopen(csvPath, "w");
+    if (!csv) {
+      fprintf(stderr, "cannot write %s\n", csvPath);
+      return 2;
+    }
+    fprintf(csv, "time_s,temp_c,rh_pct,sensor_rh_pct,abs_g_m3,humidifier,window,window_detected,water_ml\n");
+  }
+  FILE* summary = csv == stdout ? stderr : stdout;
+
+  host::setSerialOutput(log ? stderr : nullptr);
+  host::attachI2c(OLED_ADDRESS, &oledModel);
+  dhtModel.begin(DHT_PIN);
+  dhtModel.set(model.getHumidity(), model.getTemperature());
+  if (DHT2_PIN) {
+    dht2Model.begin(DHT2_PIN);
+    dht2Model.set(model.getHumidity(), model.getTemperature());
+  }
+  host::attachI2c(SHT31_ADDRESS, &shtModel);
+  shtModel.set(model.getHumidity(), model.getTemperature());
+  host::attachI2c(BME280_ADDRESS, &bmeModel);
+  bmeModel.set(model.getHumidity(), model.getTemperature());
+  host::setAnalog(WATER_LEVEL_PIN, waterAdc(model.getTankLevel()));
+  host::observePin(HUMIDIFIER_PIN, onHumidifierPin, nullptr);
+
+  setup();
+  if (minHum >= 0) storage.setMinHumidity(minHum);
+  if (maxHum >= 0) storage.setMaxHumidity(maxHum);
+
+  host::schedule(host::now() + SIM_STEP_US, onStep, nullptr);
+  bool ok = host::runLoop((uint64_t)(hours * 3600e6), loop);
+
+  if (csv && csv != stdout) fclose(csv);
+  if (!ok) {
+    fprintf(stderr, "watchdog reset at %llu ms\n", (unsigned long long)(host::now() / 1000));
+    return 3;
+  }
+
+  printSummary(summary, hours);
+  return 0;
+}
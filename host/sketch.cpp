@@ -0,0 +1,19 @@
+/*
+ * Скетч как единица трансляции C++ для сборки на ПК.
+ * Arduino IDE собирает .ino так же - одним файлом со всеми модулями
+ */
+
+#include "../Humidifier_arduino.ino"
+
+// Кадров с переполненным списком холста: прогоны на ПК считают это ошибкой
+uint16_t canvasOverflows() { return display.getCanvasOverflows(); }
+
+// Доступ к замеру отрисовки для display_bench. Сам bench.h второй раз
+// не подключить: вместе с меню он тянет обработчики прерываний
+#if DISPLAY_BENCH_ENABLED
+uint8_t benchCount() { return BENCH_COUNT; }
+const char* benchName(uint8_t c) { return (const char*)DisplayBench::getName(c); }
+void benchFillGraph() { displayBench.fillGraph(); }
+void benchPrepare(uint8_t c) { displayBench.prepare(c); }
+void benchDraw(uint8_t c) { displayBench.draw(c); }
+#endif
@@ -6,9 +6,11 @@
 #ifndef HUMIDIFIER_H
 #define HUMIDIFIER_H
 
-#include <Arduino.h>
+#include "hal.h"
 #include "config.h"
 #include "storage.h"
+#include "log.h"
+#include "fixed.h"
 
 class Humidifier {
 private:
@@ -35,7 +37,8 @@ public:
     hourStartTime = millis();
   }
 
-  void control(float currentHum, uint8_t minHum, uint8_t maxHum, bool sensorOK) {
+  // currentHum - в десятых долях %, пороги - в целых
+  void control(Deci currentHum, uint8_t minHum, uint8_t maxHum, bool sensorOK) {
     if (manualMode) return;
 
     if (!sensorOK) {
@@ -51,16 +54,19 @@ public:
     }
 
     if (switchCount >= MAX_SWITCHES_PER_HOUR) {
-      if (running) turnOff();
+      if (running) {
+        LOG_W("HUM", "switch limit reached");
+        turnOff();
+      }
       return;
     }
 
-    if (!running && currentHum < minHum) {
+    if (!running && currentHum < deciFromInt(minHum)) {
       if (now - lastSwitchTime >= MIN_PAUSE_TIME) {
         turnOn();
       }
     }
-    else if (running && currentHum >= maxHum) {
+    else if (running && currentHum >= deciFromInt(maxHum)) {
       if (now - runStartTime >= MIN_RUN_TIME) {
         turnOff();
       }
@@ -70,6 +76,7 @@ public:
   void turnOn() {
     if (!running) {
       digitalWrite(HUMIDIFIER_PIN, HIGH);
+      LOG_I("HUM", "on");
       running = true;
       runStartTime = millis();
       lastSwitchTime = millis();
@@ -84,6 +91,7 @@ public:
   void turnOff() {
     if (running) {
       digitalWrite(HUMIDIFIER_PIN, LOW);
+      LOG_I("HUM", "off");
       running = false;
       lastSwitchTime = millis();
     }
@@ -0,0 +1,132 @@
+/*
+ * ТАБЛИЦА СТРОК ИНТЕРФЕЙСА
+ * Надписи экранов и меню лежат только во flash и берутся по StringId:
+ * литерал "..." в AVR копируется в SRAM при старте, а кириллица в
+ * UTF-8 - по два байта на букву. Язык выбирается при сборке
+ * (UI_LANGUAGE в config.h), в таблице у каждой строки оба перевода.
+ *
+ * Длина надписи на экране зависит от языка, поэтому значения после
+ * подписей ставятся по uiStrChars(), а не по числу из русского текста.
+ * Знаки и числа без языка ("%", "/", "--") печатаются через F()
+ */
+
+#ifndef LANG_H
+#define LANG_H
+
+#include "hal.h"
+#include "config.h"
+
+// X(id, русский, английский)
+#define UI_STRINGS(X) \
+  X(STR_SPLASH,          "УВЛАЖНИТЕЛЬ",             "HUMIDIFIER") \
+  X(STR_ERROR,           "ОШИБКА",                  "ERROR") \
+  X(STR_SERIES_HUM,      "В",                       "H") \
+  X(STR_SERIES_BOTH,     "ВТ",                      "HT") \
+  X(STR_SERIES_TEMP,     "Т",                       "T") \
+  X(STR_VIEW_1H,         "1ч",                      "1h") \
+  X(STR_VIEW_6H,         "6ч",                      "6h") \
+  X(STR_VIEW_24H,        "24ч",                     "24h") \
+  X(STR_NO_WATER,        "NO WATER!",               "NO WATER!") \
+  X(STR_LOW,             "LOW",                     "LOW") \
+  X(STR_OK,              "OK",                      "OK") \
+  X(STR_STATS_TITLE,     "СТАТИСТИКА",              "STATISTICS") \
+  X(STR_HUMIDIFIER,      "Увлажнитель:",            "Humidifier:") \
+  X(STR_WORK,            "Работа:",                 "Runtime:") \
+  X(STR_WATER,           "Вода:",                   "Water:") \
+  X(STR_ON,              "ВКЛ",                     "ON") \
+  X(STR_OFF,             "ВЫКЛ",                    "OFF") \
+  X(STR_HOURS,           "ч",                       "h") \
+  X(STR_MINUTES,         "м",                       "m") \
+  X(STR_PER_HOUR,        "/ч",                      "/h") \
+  X(STR_NONE,            "НЕТ",                     "NONE") \
+  X(STR_WATER_LOW,       "НИЗКО!",                  "LOW!") \
+  X(STR_HINT_SELECT,     "Поворот-выбор",           "Turn - select") \
+  X(STR_ABOUT_TITLE,     "О СИСТЕМЕ",               "ABOUT") \
+  X(STR_SWITCHES,        "Перекл:",                 "Switch:") \
+  X(STR_HINT_HOLD_EXIT,  "ДЛ-выход",                "Hold-exit") \
+  X(STR_CAL_TITLE,       "КАЛИБРОВКА",              "CALIBRATION") \
+  X(STR_CAL_TEMP_NOW,    "Т:",                      "T:") \
+  X(STR_CAL_HUM_NOW,     "C В:",                    "C H:") \
+  X(STR_CAL_TEMP,        "КорТ:",                   "CorT:") \
+  X(STR_CAL_HUM,         "КорВ:",                   "CorH:") \
+  X(STR_HINT_CAL,        "КН- след ДЛ-OK",          "Clk-next Hold-OK") \
+  X(STR_WATER_CAL_TITLE, "ПОРОГ ВОДЫ",              "WATER LIMIT") \
+  X(STR_NO_SENSOR,       "НЕТ ДАТЧИКА!",            "NO SENSOR!") \
+  X(STR_CURRENT,         "Текущий:",                "Current:") \
+  X(STR_THRESHOLD,       "Порог:",                  "Limit:") \
+  X(STR_LOW_WATER,       "НИЗКАЯ ВОДА!",            "LOW WATER!") \
+  X(STR_LEVEL,           "Уровень:",                "Level:") \
+  X(STR_HINT_WATER_CAL,  "КН-меню ДЛ-сохр",         "Clk-menu Hold-save") \
+  X(STR_MANUAL_TITLE,    "РУЧНОЙ РЕЖИМ",            "MANUAL MODE") \
+  X(STR_HINT_TOGGLE,     "Поворот:перекл",          "Turn:toggle") \
+  X(STR_HINT_CLICK_EXIT, "КН-выход",                "Clk-exit") \
+  X(STR_MENU_TITLE,      "MENU",                    "MENU") \
+  X(STR_MENU_HINT,       "R-вперед L-наз. DC-exit", "R-next L-prev DC-exit") \
+  X(STR_MENU_MIN_HUM,    "Минимальная влажность",   "Min humidity") \
+  X(STR_MENU_MAX_HUM,    "Макс влажность",          "Max humidity") \
+  X(STR_MENU_HYST,       "Гистерезис",              "Hysteresis") \
+  X(STR_MENU_CALIBRATE,  "Калибровка",              "Calibration") \
+  X(STR_MENU_WATER,      "Порог воды",              "Water limit") \
+  X(STR_MENU_MANUAL,     "Ручной режим",            "Manual mode") \
+  X(STR_MENU_DISPLAY,    "Настройка дисплея",       "Display") \
+  X(STR_MENU_RESET,      "Сброс статистики",        "Reset stats") \
+  X(STR_MENU_DIAG,       "Диагностика",             "Diagnostics") \
+  X(STR_MENU_ABOUT,      "О программе",             "About") \
+  X(STR_MENU_EXIT,       "Выход",                   "Exit") \
+  X(STR_DISPLAY_TITLE,   "ДИСПЛЕЙ",                 "DISPLAY") \
+  X(STR_DISPLAY_HINT,    "L-назад",                 "L-back") \
+  X(STR_BRIGHTNESS,      "Яркость",                 "Brightness") \
+  X(STR_TIMEOUT,         "Таймаут",                 "Timeout") \
+  X(STR_BACK,            "Назад",                   "Back") \
+  X(STR_EDIT_TITLE,      "НАСТРОЙКА",               "SETTING") \
+  X(STR_EDIT_HINT,       "R+/- L-наз. CLICK-ок",    "R+/- L-back CLICK-ok") \
+  X(STR_DIAG_TITLE,      "ДИАГНОСТИКА",             "DIAGNOSTICS") \
+  X(STR_NO_DATA,         "Нет данных",              "No data") \
+  X(STR_MENU_MEMORY,     "Память",                  "Memory") \
+  X(STR_MEMORY_TITLE,    "ПАМЯТЬ",                  "MEMORY") \
+  X(STR_STACK,           "Стек:",                   "Stack:") \
+  X(STR_FREE,            "Своб:",                   "Free:") \
+  X(STR_SPARE,           "Запас:",                  "Spare:") \
+  X(STR_STATIC,          "Стат:",                   "Stat:") \
+  X(STR_MODULES,         "Модули:",                 "Modules:") \
+  X(STR_SENSORS_TITLE,   "ДАТЧИКИ",                 "SENSORS") \
+  X(STR_ROOM,            "Комната",                 "Room")
+
+#define UI_STRING_ID(id, ru, en) id,
+enum StringId {
+  UI_STRINGS(UI_STRING_ID)
+  STR_COUNT
+};
+#undef UI_STRING_ID
+
+#if UI_LANGUAGE == LANG_EN
+  #define UI_STRING_TEXT(id, ru, en) static const char id##_TEXT[] PROGMEM = en;
+#else
+  #define UI_STRING_TEXT(id, ru, en) static const char id##_TEXT[] PROGMEM = ru;
+#endif
+UI_STRINGS(UI_STRING_TEXT)
+#undef UI_STRING_TEXT
+
+#define UI_STRING_PTR(id, ru, en) id##_TEXT,
+static const char* const uiStrings[STR_COUNT] PROGMEM = {
+  UI_STRINGS(UI_STRING_PTR)
+};
+#undef UI_STRING_PTR
+
+// Строка для print(): Display, PageCanvas и Print понимают F-строки
+inline const __FlashStringHelper* uiStr(uint8_t id) {
+  return reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&uiStrings[id]));
+}
+
+// Символов на экране: продолжения UTF-8 (10xxxxxx) не считаются
+inline uint8_t uiStrChars(uint8_t id) {
+  const char* s = reinterpret_cast<const char*>(uiStr(id));
+  uint8_t n = 0;
+  for (;; s++) {
+    uint8_t c = pgm_read_byte(s);
+    if (!c) return n;
+    if ((c & 0xC0) != 0x80) n++;
+  }
+}
+
+#endif // LANG_H
@@ -0,0 +1,135 @@
+/*
+ * МОДУЛЬ ЖУРНАЛА
+ * Уровни и теги модулей, строки формата во flash.
+ * Запись форматируется в кольцевой буфер и выводится в Serial
+ * по мере освобождения буфера UART. Если места нет - строка
+ * отбрасывается и увеличивается счетчик, loop() не блокируется.
+ * Вызовы ниже LOG_LEVEL (config.h) не компилируются вовсе.
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include "hal.h"
+#include <stdarg.h>
+#include "config.h"
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+
+#define LOG_BUFFER_MASK (LOG_BUFFER_SIZE - 1)
+
+class Logger {
+private:
+  char buffer[LOG_BUFFER_SIZE];
+  uint8_t head;
+  uint8_t tail;
+  uint16_t dropped;
+  bool blocking;
+
+  uint8_t freeSpace() const {
+    return (tail - head - 1) & LOG_BUFFER_MASK;
+  }
+
+  void drainBlocking() {
+    while (tail != head) {
+      Serial.write(buffer[tail]);
+      tail = (tail + 1) & LOG_BUFFER_MASK;
+    }
+  }
+
+public:
+  Logger() : head(0), tail(0), dropped(0), blocking(false) {}
+
+  // Блокирующий режим для setup(): при нехватке места ждем UART
+  void setBlocking(bool enable) {
+    blocking = enable;
+    if (!enable) return;
+    drainBlocking();
+  }
+
+  // tag и fmt - строки во flash (PSTR)
+  void write(uint8_t level, const char* tag, const char* fmt, ...) {
+    static const char levels[] PROGMEM = "?EWID";
+    char line[LOG_LINE_MAX];
+
+    line[0] = pgm_read_byte(&levels[level]);
+    line[1] = ' ';
+    uint8_t len = 2;
+    char c;
+    while (len < 2 + LOG_TAG_MAX && (c = pgm_read_byte(tag++)) != '\0') {
+      line[len++] = c;
+    }
+    line[len++] = ':';
+    line[len++] = ' ';
+
+    va_list args;
+    va_start(args, fmt);
+    // Два байта в конце - под перевод строки
+    vsnprintf_P(line + len, LOG_LINE_MAX - 2 - len, fmt, args);
+    va_end(args);
+    len = strlen(line);
+    line[len++] = '\r';
+    line[len++] = '\n';
+
+    if (freeSpace() < len) {
+      if (!blocking) {
+        if (dropped < 0xFFFF) dropped++;
+        return;
+      }
+      drainBlocking();
+    }
+
+    for (uint8_t i = 0; i < len; i++) {
+      buffer[head] = line[i];
+      head = (head + 1) & LOG_BUFFER_MASK;
+    }
+  }
+
+  // Вывод накопленного без ожидания (вызывать в loop)
+  void flush() {
+    int room = Serial.availableForWrite();
+    while (room-- > 0 && tail != head) {
+      Serial.write(buffer[tail]);
+      tail = (tail + 1) & LOG_BUFFER_MASK;
+    }
+  }
+
+  uint16_t getDropped() const { return dropped; }
+};
+
+extern Logger logger;
+
+#define LOG_WRITE(level, tag, fmt, ...) logger.write(level, PSTR(tag), PSTR(fmt), ##__VA_ARGS__)
+#define LOG_FLUSH() logger.flush()
+
+#else
+
+#define LOG_FLUSH() do {} while (0)
+
+#endif // LOG_LEVEL > LOG_LEVEL_NONE
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+  #define LOG_E(tag, fmt, ...) LOG_WRITE(LOG_LEVEL_ERROR, tag, fmt, ##__VA_ARGS__)
+#else
+  #define LOG_E(tag, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+  #define LOG_W(tag, fmt, ...) LOG_WRITE(LOG_LEVEL_WARN, tag, fmt, ##__VA_ARGS__)
+#else
+  #define LOG_W(tag, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+  #define LOG_I(tag, fmt, ...) LOG_WRITE(LOG_LEVEL_INFO, tag, fmt, ##__VA_ARGS__)
+#else
+  #define LOG_I(tag, fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+  #define LOG_D(tag, fmt, ...) LOG_WRITE(LOG_LEVEL_DEBUG, tag, fmt, ##__VA_ARGS__)
+#else
+  #define LOG_D(tag, fmt, ...) do {} while (0)
+#endif
+
+#endif // LOG_H
@@ -0,0 +1,104 @@
+/*
+ * МОНИТОР ПАМЯТИ
+ * SRAM у Nano 2 КБ, и статические объекты модулей, буферы Serial
+ * и очереди I2C подходят к стеку вплотную. Свободная область
+ * заливается при старте (hal_avr.h), check() находит, докуда стек
+ * опускался, и пишет в журнал, если запас стал меньше
+ * MEMORY_STACK_WARN. Размеры объектов модулей - таблица из скетча
+ */
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include "hal.h"
+#include "config.h"
+#include "log.h"
+
+// Строка таблицы размеров: имя во flash и sizeof объекта
+struct MemoryModule {
+  const char* name;
+  uint16_t size;
+};
+
+class MemoryMonitor {
+private:
+  const MemoryModule* modules;   // Во flash
+  uint8_t moduleCount;
+  uint16_t spare;                // Нетронутых байт при последней проверке
+  bool warned;
+
+public:
+  MemoryMonitor() : modules(nullptr), moduleCount(0), spare(0), warned(false) {}
+
+  void setModules(const MemoryModule* table, uint8_t count) {
+    modules = table;
+    moduleCount = count;
+  }
+
+  // Проход по заливке: на Nano ~0,1 мс на 256 нетронутых байт
+  void check() {
+    spare = halStackUntouched();
+    if (halRamTop() && spare < MEMORY_STACK_WARN && !warned) {
+      LOG_W("MEM", "stack spare %u", spare);
+      warned = true;
+    }
+  }
+
+  // .data + .bss
+  uint16_t getStaticBytes() const { return halStaticBytes(); }
+  // Между кучей и стеком сейчас
+  uint16_t getFree() const { return halStackPointer() - halHeapEnd(); }
+  // Меньше всего было свободно: нетронутая заливка
+  uint16_t getSpare() const { return spare; }
+  // Глубина стека за все время
+  uint16_t getStackMax() const {
+    return halRamTop() ? halRamTop() - halHeapEnd() - spare : 0;
+  }
+
+  uint8_t getModuleCount() const { return moduleCount; }
+
+  const __FlashStringHelper* getModuleName(uint8_t i) const {
+    return reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&modules[i].name));
+  }
+
+  uint16_t getModuleSize(uint8_t i) const {
+    return pgm_read_word(&modules[i].size);
+  }
+
+  uint16_t getModulesBytes() const {
+    uint16_t sum = 0;
+    for (uint8_t i = 0; i < moduleCount; i++) sum += getModuleSize(i);
+    return sum;
+  }
+
+  // Индекс модуля, rank-го по размеру (0 - самый большой)
+  uint8_t getLargest(uint8_t rank) const {
+    for (uint8_t i = 0; i < moduleCount; i++) {
+      uint16_t size = getModuleSize(i);
+      uint8_t above = 0;
+      for (uint8_t j = 0; j < moduleCount; j++) {
+        uint16_t other = getModuleSize(j);
+        if (other > size || (other == size && j < i)) above++;
+      }
+      if (above == rank) return i;
+    }
+    return 0;
+  }
+
+  void dump(Print& out) {
+    check();
+    out.println(F("=== MEM, bytes ==="));
+    out.print(F("static=")); out.print(getStaticBytes());
+    out.print(F(" free=")); out.print(getFree());
+    out.print(F(" spare=")); out.print(getSpare());
+    out.print(F(" stack_max=")); out.println(getStackMax());
+    for (uint8_t i = 0; i < moduleCount; i++) {
+      out.print(getModuleName(i));
+      out.print(' ');
+      out.println(getModuleSize(i));
+    }
+    out.print(F("modules=")); out.println(getModulesBytes());
+  }
+};
+
+#endif // MEMORY_H
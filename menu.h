@@ -1,11 +1,15 @@
 /*
- * МОДУЛЬ МЕНЮ v2.0
+ * МОДУЛЬ МЕНЮ v3.0
+ * Пункты описаны таблицами во flash (MenuItemDesc): подпись (lang.h), тип,
+ * пределы и шаги, чтение и запись значения в Storage, ссылка на свой
+ * экран или вложенный список. Обработка энкодера одна на все пункты,
+ * новая настройка - строка таблицы
  */
 
 #ifndef MENU_H
 #define MENU_H
 
-#include <Arduino.h>
+#include "hal.h"
 #include "config.h"
 #include "display.h"
 #include "encoder.h"
@@ -13,19 +17,117 @@
 #include "sensor.h"
 #include "humidifier.h"
 #include "analytics.h"
+#include "profiler.h"
+#include "memory.h"
 
-enum MenuItem {
-  MENU_MIN_HUMIDITY = 0,
-  MENU_MAX_HUMIDITY = 1,
-  MENU_HYSTERESIS = 2,
-  MENU_CALIBRATE = 3,
-  MENU_WATER_THRESHOLD = 4,
-  MENU_MANUAL = 5,
-  MENU_DISPLAY = 6,
-  MENU_RESET_STATS = 7,
-  MENU_ABOUT = 8,
-  MENU_EXIT = 9,
-  MENU_COUNT = 10
+#define MENU_ROWS 5   // Пунктов на экране, страницы 2-6
+
+enum MenuItemType {
+  ITEM_VALUE = 0,    // Число из Storage, правится на экране настройки
+  ITEM_SCREEN = 1,   // Свой экран: link - MenuScreen
+  ITEM_SUBMENU = 2,  // Вложенный список: link - MenuListId
+  ITEM_ACTION = 3    // Действие по нажатию: link - MenuAction
+};
+
+enum MenuScreen {
+  SCREEN_LIST = 0,        // Список пунктов
+  SCREEN_EDIT = 1,        // Правка пункта ITEM_VALUE
+  SCREEN_CALIBRATE = 2,   // Две поправки из calibrationItems
+  SCREEN_WATER = 3,       // Порог воды с текущим уровнем
+  SCREEN_MANUAL = 4,
+  SCREEN_ABOUT = 5,
+  SCREEN_DIAGNOSTICS = 6,
+  SCREEN_MEMORY = 7
+};
+
+enum MenuAction {
+  ACTION_NONE = 0,
+  ACTION_RESET_STATS = 1,
+  ACTION_EXIT = 2,
+  ACTION_BRIGHTNESS = 3,  // 100% <-> 75%, значение видно у пункта
+  ACTION_BACK = 4         // Из вложенного списка в главный
+};
+
+enum MenuListId {
+  MENU_LIST_MAIN = 0,
+  MENU_LIST_DISPLAY = 1
+};
+
+typedef int16_t (*MenuGetter)(Storage* s);
+typedef void (*MenuSetter)(Storage* s, int16_t value);
+
+struct MenuItemDesc {
+  uint8_t label;           // StringId
+  uint8_t type;            // MenuItemType
+  uint8_t link;
+  int16_t minValue, maxValue;
+  uint8_t step, fastStep;  // Шаг поворота, быстрого поворота
+  MenuGetter get;
+  MenuSetter set;
+  const char* unit;        // Во flash или nullptr
+};
+
+struct MenuListDesc {
+  uint8_t title;           // StringId
+  uint8_t titleX;
+  uint8_t hint;            // StringId подсказки внизу экрана
+  const MenuItemDesc* items;
+  uint8_t count;
+};
+
+// Привязки к Storage. Поправки калибровки - в десятых долях, как и в Storage
+static int16_t menuGetMinHum(Storage* s) { return s->getMinHumidity(); }
+static void menuSetMinHum(Storage* s, int16_t v) { s->setMinHumidity(v); }
+static int16_t menuGetMaxHum(Storage* s) { return s->getMaxHumidity(); }
+static void menuSetMaxHum(Storage* s, int16_t v) { s->setMaxHumidity(v); }
+static int16_t menuGetHyst(Storage* s) { return s->getHysteresis(); }
+static void menuSetHyst(Storage* s, int16_t v) { s->setHysteresis(v); }
+static int16_t menuGetWater(Storage* s) { return s->getWaterThreshold(); }
+static void menuSetWater(Storage* s, int16_t v) { s->setWaterThreshold(v); }
+
+static int16_t menuGetTempCal(Storage* s) { return s->getTempCalibration(); }
+static void menuSetTempCal(Storage* s, int16_t v) { s->setTempCalibration(v); }
+static int16_t menuGetHumCal(Storage* s) { return s->getHumCalibration(); }
+static void menuSetHumCal(Storage* s, int16_t v) { s->setHumCalibration(v); }
+
+static const char menuUnitPercent[] PROGMEM = "%";
+
+static const MenuItemDesc mainMenuItems[] PROGMEM = {
+  { STR_MENU_MIN_HUM, ITEM_VALUE, 0, 20, 80, 1, 5, menuGetMinHum, menuSetMinHum, menuUnitPercent },
+  { STR_MENU_MAX_HUM, ITEM_VALUE, 0, 30, 90, 1, 5, menuGetMaxHum, menuSetMaxHum, menuUnitPercent },
+  { STR_MENU_HYST, ITEM_VALUE, 0, 1, 20, 1, 5, menuGetHyst, menuSetHyst, menuUnitPercent },
+  { STR_MENU_CALIBRATE, ITEM_SCREEN, SCREEN_CALIBRATE, 0, 0, 0, 0, nullptr, nullptr, nullptr },
+  { STR_MENU_WATER, ITEM_SCREEN, SCREEN_WATER, 30, 900, 10, 50, menuGetWater, menuSetWater, nullptr },
+  { STR_MENU_MANUAL, ITEM_SCREEN, SCREEN_MANUAL, 0, 0, 0, 0, nullptr, nullptr, nullptr },
+  { STR_MENU_DISPLAY, ITEM_SUBMENU, MENU_LIST_DISPLAY, 0, 0, 0, 0, nullptr, nullptr, nullptr },
+  { STR_MENU_RESET, ITEM_ACTION, ACTION_RESET_STATS, 0, 0, 0, 0, nullptr, nullptr, nullptr },
+#if PROFILER_ENABLED
+  { STR_MENU_DIAG, ITEM_SCREEN, SCREEN_DIAGNOSTICS, 0, 0, 0, 0, nullptr, nullptr, nullptr },
+#endif
+#if MEMORY_MONITOR_ENABLED
+  { STR_MENU_MEMORY, ITEM_SCREEN, SCREEN_MEMORY, 0, 0, 0, 0, nullptr, nullptr, nullptr },
+#endif
+  { STR_MENU_ABOUT, ITEM_SCREEN, SCREEN_ABOUT, 0, 0, 0, 0, nullptr, nullptr, nullptr },
+  { STR_MENU_EXIT, ITEM_ACTION, ACTION_EXIT, 0, 0, 0, 0, nullptr, nullptr, nullptr }
+};
+
+static const MenuItemDesc displayMenuItems[] PROGMEM = {
+  { STR_BRIGHTNESS, ITEM_ACTION, ACTION_BRIGHTNESS, 0, 0, 0, 0, nullptr, nullptr, nullptr },
+  { STR_TIMEOUT, ITEM_ACTION, ACTION_NONE, 0, 0, 0, 0, nullptr, nullptr, nullptr },
+  { STR_BACK, ITEM_ACTION, ACTION_BACK, 0, 0, 0, 0, nullptr, nullptr, nullptr }
+};
+
+// Экран калибровки: поправки температуры и влажности, десятые доли
+static const MenuItemDesc calibrationItems[] PROGMEM = {
+  { STR_MENU_CALIBRATE, ITEM_VALUE, 0, -100, 100, 1, 5, menuGetTempCal, menuSetTempCal, nullptr },
+  { STR_MENU_CALIBRATE, ITEM_VALUE, 0, -200, 200, 1, 5, menuGetHumCal, menuSetHumCal, nullptr }
+};
+
+static const MenuListDesc menuLists[] PROGMEM = {
+  { STR_MENU_TITLE, 40, STR_MENU_HINT, mainMenuItems,
+    sizeof(mainMenuItems) / sizeof(mainMenuItems[0]) },
+  { STR_DISPLAY_TITLE, 25, STR_DISPLAY_HINT, displayMenuItems,
+    sizeof(displayMenuItems) / sizeof(displayMenuItems[0]) }
 };
 
 class Menu {
@@ -36,60 +138,67 @@ private:
   Sensor* sensor;
   Humidifier* humidifier;
   Analytics* analytics;
+  Profiler* profiler;
+  MemoryMonitor* memory;
 
   bool active;
-  uint8_t currentItem;
-  bool editMode;
-  int16_t editValue;
+  uint8_t screen;        // MenuScreen
+  uint8_t listId;        // MenuListId
+  uint8_t currentItem;   // Пункт списка listId
+  uint8_t parentItem;    // Пункт главного списка, открывший вложенный
+  // Правимые значения: SCREEN_EDIT и SCREEN_WATER - values[0],
+  // SCREEN_CALIBRATE - обе поправки, valueIndex - текущая
+  int16_t values[2];
+  uint8_t valueIndex;
+  bool manualState;
   unsigned long lastActivityTime;
-  bool menuJustOpened;
+  unsigned long lastDiagDraw;
+  uint8_t diagPass;      // Проход отрисовки страницы диагностики
+  bool needRedraw;
 
-  bool calibrationMode;
-  uint8_t calibrationStep;
-  float tempCalValue;
-  float humCalValue;
+  // Список на экране: первый видимый пункт и пункт под курсором.
+  // -1 - на экране другое, список рисуется целиком
+  int8_t shownStart;
+  uint8_t shownItem;
 
-  bool waterCalMode;
-  uint16_t waterThreshold;
+  static void readList(uint8_t id, MenuListDesc& list) {
+    memcpy_P(&list, &menuLists[id], sizeof(list));
+  }
 
-  bool manualMode;
-  bool manualState;
+  static void readItem(const MenuItemDesc* items, uint8_t i, MenuItemDesc& item) {
+    memcpy_P(&item, &items[i], sizeof(item));
+  }
 
-  bool displaySettingsMode;
-  uint8_t displaySubItem;
+  uint8_t listCount() const {
+    return pgm_read_byte(&menuLists[listId].count);
+  }
 
-  bool aboutMode;
-  bool needRedraw;
+  void readCurrent(MenuItemDesc& item) const {
+    MenuListDesc list;
+    readList(listId, list);
+    readItem(list.items, currentItem, item);
+  }
 
-  const char* menuItems[10] = {
-    "Минимальная влажность",
-    "Макс влажность",
-    "Гистерезис",
-    "Калибровка",
-    "Порог воды",
-    "Ручной режим",
-    "Настройка дисплея",
-    "Сброс статистики",
-    "О программе",
-    "Выход"
-  };
-
-  const char* displayMenuItems[3] = {
-    "Яркость",
-    "Таймаут",
-    "Назад"
-  };
+  // Описание значения, которое правится на текущем экране
+  void readEdited(MenuItemDesc& item) const {
+    if (screen == SCREEN_CALIBRATE) readItem(calibrationItems, valueIndex, item);
+    else readCurrent(item);
+  }
+
+  static const __FlashStringHelper* flash(const char* s) {
+    return reinterpret_cast<const __FlashStringHelper*>(s);
+  }
 
 public:
-  Menu() : display(nullptr), encoder(nullptr), storage(nullptr), 
-           sensor(nullptr), humidifier(nullptr), analytics(nullptr),
-           active(false), currentItem(0), editMode(false), editValue(0),
-           lastActivityTime(0), menuJustOpened(false),
-           calibrationMode(false), calibrationStep(0),
-           tempCalValue(0), humCalValue(0), waterCalMode(false),
-           waterThreshold(WATER_THRESHOLD), manualMode(false), manualState(false),
-           displaySettingsMode(false), displaySubItem(0),
-           aboutMode(false), needRedraw(true) {}
+  Menu() : display(nullptr), encoder(nullptr), storage(nullptr),
+           sensor(nullptr), humidifier(nullptr), analytics(nullptr), profiler(nullptr),
+           memory(nullptr),
+           active(false), screen(SCREEN_LIST), listId(MENU_LIST_MAIN),
+           currentItem(0), parentItem(0), valueIndex(0), manualState(false),
+           lastActivityTime(0), lastDiagDraw(0), diagPass(0),
+           needRedraw(true), shownStart(-1), shownItem(0) {
+    values[0] = values[1] = 0;
+  }
 
   void begin(Display* disp, EncoderModule* enc, Storage* stor, Sensor* sens, Humidifier* hum) {
     display = disp;
@@ -101,23 +210,21 @@ public:
   }
 
   void setAnalytics(Analytics* ana) { analytics = ana; }
+  void setProfiler(Profiler* prof) { profiler = prof; }
+  void setMemory(MemoryMonitor* mem) { memory = mem; }
 
   void open() {
     active = true;
     currentItem = 0;
-    menuJustOpened = true;
     resetModes();
     needRedraw = true;
+    shownStart = -1;
     lastActivityTime = millis();
   }
 
   void resetModes() {
-    editMode = false;
-    calibrationMode = false;
-    waterCalMode = false;
-    manualMode = false;
-    displaySettingsMode = false;
-    aboutMode = false;
+    screen = SCREEN_LIST;
+    listId = MENU_LIST_MAIN;
   }
 
   void close() {
@@ -127,307 +234,462 @@ public:
   }
 
   bool isActive() const { return active; }
+  bool isRedrawPending() const { return active && needRedraw; }
+
+  // Курсор списка: замер отрисовки (bench.h) возвращает его на место
+  uint8_t getCurrentItem() const { return currentItem; }
+  void setCurrentItem(uint8_t item) {
+    currentItem = item;
+    shownStart = -1;
+    needRedraw = true;
+  }
 
   void tick() {
     if (!active) return;
     if (millis() - lastActivityTime > SCREEN_TIMEOUT) { close(); return; }
 
-    if (menuJustOpened) {
-      menuJustOpened = false;
-      return;
+    // Страницы диагностики и памяти обновляются сами
+    if ((screen == SCREEN_DIAGNOSTICS || screen == SCREEN_MEMORY) &&
+        millis() - lastDiagDraw >= DIAG_REFRESH_INTERVAL) {
+      needRedraw = true;
     }
 
-    if (encoder->isDouble()) {
+    uint8_t event;
+    while (active && (event = encoder->popEvent()) != ENC_EVENT_NONE) {
+      handleEvent(event);
+    }
+  }
+
+  // Обработка одного события энкодера
+  void handleEvent(uint8_t event) {
+    uint8_t type = event & ENC_EVENT_MASK;
+    bool fast = (event & ENC_EVENT_FAST) != 0;
+
+    if (type == ENC_EVENT_DOUBLE) {
       close();
       return;
     }
 
-    if (encoder->isRight()) {
-      if (editMode) {
-        if (encoder->isFastRotate()) editValue += 5;
-        else editValue++;
-        switch (currentItem) {
-          case MENU_MIN_HUMIDITY: editValue = constrain(editValue, 20, 80); break;
-          case MENU_MAX_HUMIDITY: editValue = constrain(editValue, 30, 90); break;
-          case MENU_HYSTERESIS: editValue = constrain(editValue, 1, 20); break;
+    if (type == ENC_EVENT_RIGHT || type == ENC_EVENT_LEFT) {
+      turn(type == ENC_EVENT_RIGHT ? 1 : -1, fast);
+    }
+
+    if (type == ENC_EVENT_CLICK) {
+      click();
+    }
+
+    if (type == ENC_EVENT_HOLD) {
+      if (screen == SCREEN_CALIBRATE) {
+        // При длинном нажатии в режиме калибровки - сохраняем и выходим
+        for (uint8_t i = 0; i < 2; i++) {
+          MenuItemDesc item;
+          readItem(calibrationItems, i, item);
+          item.set(storage, values[i]);
         }
-        needRedraw = true;
-      }
-      else if (calibrationMode) {
-        float step = encoder->isFastRotate() ? 0.5 : 0.1;
-        if (calibrationStep == 0) {
-          tempCalValue += step;
-          tempCalValue = constrain(tempCalValue, -10.0, 10.0);
-        } else {
-          humCalValue += step;
-          humCalValue = constrain(humCalValue, -20.0, 20.0);
+        storage->save();
+        screen = SCREEN_LIST;
+      } else if (screen == SCREEN_WATER) {
+        // При длинном нажатии устанавливаем порог = текущий уровень воды
+        if (analytics) {
+          MenuItemDesc item;
+          readCurrent(item);
+          item.set(storage, constrain(analytics->getWaterRawValue(), item.minValue, item.maxValue));
+          storage->save();
         }
-        needRedraw = true;
-      }
-      else if (waterCalMode) {
-        uint16_t step = encoder->isFastRotate() ? 50 : 10;
-        waterThreshold += step;
-        waterThreshold = constrain(waterThreshold, 30, 900);
-        needRedraw = true;
-      }
-      else if (manualMode) {
-        manualState = !manualState;
-        if (manualState) humidifier->turnOn();
-        else humidifier->turnOff();
-        needRedraw = true;
-      }
-      else if (displaySettingsMode) {
-        displaySubItem++;
-        if (displaySubItem >= 3) displaySubItem = 0;
-        needRedraw = true;
-      }
-      else {
-        currentItem++;
-        if (currentItem >= MENU_COUNT) currentItem = 0;
-        needRedraw = true;
+        screen = SCREEN_LIST;
+      } else {
+        close();
       }
+      needRedraw = true;
       lastActivityTime = millis();
     }
+  }
 
-    if (encoder->isLeft()) {
-      if (editMode) {
-        if (encoder->isFastRotate()) editValue -= 5;
-        else editValue--;
-        switch (currentItem) {
-          case MENU_MIN_HUMIDITY: editValue = constrain(editValue, 20, 80); break;
-          case MENU_MAX_HUMIDITY: editValue = constrain(editValue, 30, 90); break;
-          case MENU_HYSTERESIS: editValue = constrain(editValue, 1, 20); break;
-        }
-        needRedraw = true;
+  // Поворот: правка значения, переключение в ручном режиме или курсор
+  void turn(int8_t dir, bool fast) {
+    switch (screen) {
+      case SCREEN_EDIT:
+      case SCREEN_CALIBRATE:
+      case SCREEN_WATER: {
+        MenuItemDesc item;
+        readEdited(item);
+        int16_t v = values[valueIndex] + dir * (fast ? item.fastStep : item.step);
+        values[valueIndex] = constrain(v, item.minValue, item.maxValue);
+        break;
       }
-      else if (calibrationMode) {
-        float step = encoder->isFastRotate() ? 0.5 : 0.1;
-        if (calibrationStep == 0) {
-          tempCalValue -= step;
-          tempCalValue = constrain(tempCalValue, -10.0, 10.0);
-        } else {
-          humCalValue -= step;
-          humCalValue = constrain(humCalValue, -20.0, 20.0);
-        }
-        needRedraw = true;
-      }
-      else if (waterCalMode) {
-        uint16_t step = encoder->isFastRotate() ? 50 : 10;
-        if (waterThreshold > step) waterThreshold -= step;
-        else waterThreshold = 30;
-        needRedraw = true;
-      }
-      else if (manualMode) {
+      case SCREEN_MANUAL:
         manualState = !manualState;
         if (manualState) humidifier->turnOn();
         else humidifier->turnOff();
-        needRedraw = true;
-      }
-      else if (displaySettingsMode) {
-        if (displaySubItem == 0) displaySubItem = 2;
-        else displaySubItem--;
-        needRedraw = true;
-      }
-      else {
-        if (currentItem == 0) currentItem = MENU_COUNT - 1;
-        else currentItem--;
-        needRedraw = true;
-      }
-      lastActivityTime = millis();
+        break;
+      case SCREEN_LIST:
+        if (dir > 0) currentItem = currentItem + 1 >= listCount() ? 0 : currentItem + 1;
+        else currentItem = currentItem == 0 ? listCount() - 1 : currentItem - 1;
+        break;
+      default:
+        return;
     }
+    needRedraw = true;
+    lastActivityTime = millis();
+  }
 
-    if (encoder->isClick()) {
-      if (editMode) {
-        switch (currentItem) {
-          case MENU_MIN_HUMIDITY: storage->setMinHumidity(editValue); break;
-          case MENU_MAX_HUMIDITY: storage->setMaxHumidity(editValue); break;
-          case MENU_HYSTERESIS: storage->setHysteresis(editValue); break;
-        }
-        editMode = false;
-      }
-      else if (calibrationMode) {
-        calibrationStep = (calibrationStep == 0) ? 1 : 0;
+  void click() {
+    switch (screen) {
+      case SCREEN_EDIT: {
+        MenuItemDesc item;
+        readCurrent(item);
+        item.set(storage, values[0]);
+        screen = SCREEN_LIST;
+        break;
       }
-      else if (waterCalMode) {
-        storage->setWaterThreshold(waterThreshold);
+      case SCREEN_CALIBRATE:
+        valueIndex = valueIndex == 0 ? 1 : 0;
+        break;
+      case SCREEN_WATER: {
+        MenuItemDesc item;
+        readCurrent(item);
+        item.set(storage, values[0]);
         storage->save();
-        waterCalMode = false;
+        screen = SCREEN_LIST;
+        break;
       }
-      else if (manualMode) {
+      case SCREEN_MANUAL:
         humidifier->exitManualMode();
-        manualMode = false;
-      }
-      else if (displaySettingsMode) {
-        if (displaySubItem == 2) {
-          displaySettingsMode = false;
-        } else if (displaySubItem == 0) {
-          uint8_t b = display->getBrightness();
-          if (b == BRIGHTNESS_FULL) display->setBrightness(BRIGHTNESS_DIM1);
-          else display->setBrightness(BRIGHTNESS_FULL);
-        }
-      }
-      else if (aboutMode) {
-        aboutMode = false;
-      }
-      else {
+        screen = SCREEN_LIST;
+        break;
+      case SCREEN_LIST:
         selectMenuItem();
-      }
-      needRedraw = true;
-      lastActivityTime = millis();
+        break;
+      default:
+        screen = SCREEN_LIST;
+        break;
     }
+    needRedraw = true;
+    lastActivityTime = millis();
+  }
 
-    if (encoder->isLongPress()) {
-      encoder->clearLongPress();
-      if (calibrationMode) {
-        // При длинном нажатии в режиме калибровки - сохраняем и выходим
-        storage->setTempCalibration(tempCalValue);
-        storage->setHumCalibration(humCalValue);
-        storage->save();
-        calibrationMode = false;
-      } else if (waterCalMode) {
-        // При длинном нажатии устанавливаем порог = текущий уровень воды
-        if (analytics) {
-          waterThreshold = analytics->getWaterRawValue();
-          waterThreshold = constrain(waterThreshold, 30, 900);
-          storage->setWaterThreshold(waterThreshold);
-          storage->save();
+  void selectMenuItem() {
+    MenuItemDesc item;
+    readCurrent(item);
+    switch (item.type) {
+      case ITEM_VALUE:
+        values[0] = item.get(storage);
+        valueIndex = 0;
+        screen = SCREEN_EDIT;
+        break;
+      case ITEM_SCREEN:
+        openScreen(item);
+        break;
+      case ITEM_SUBMENU:
+        parentItem = currentItem;
+        listId = item.link;
+        currentItem = 0;
+        shownStart = -1;
+        break;
+      case ITEM_ACTION:
+        runAction(item.link);
+        break;
+    }
+  }
+
+  void openScreen(const MenuItemDesc& item) {
+    screen = item.link;
+    valueIndex = 0;
+    switch (item.link) {
+      case SCREEN_CALIBRATE:
+        for (uint8_t i = 0; i < 2; i++) {
+          MenuItemDesc cal;
+          readItem(calibrationItems, i, cal);
+          values[i] = cal.get(storage);
         }
-        waterCalMode = false;
-      } else {
-        close();
-      }
-      needRedraw = true;
-      lastActivityTime = millis();
+        break;
+      case SCREEN_WATER:
+        values[0] = item.get(storage);
+        break;
+      case SCREEN_MANUAL:
+        manualState = humidifier->isRunning();
+        humidifier->toggle();
+        break;
     }
   }
 
-  void selectMenuItem() {
-    switch (currentItem) {
-      case MENU_MIN_HUMIDITY: editValue = storage->getMinHumidity(); editMode = true; break;
-      case MENU_MAX_HUMIDITY: editValue = storage->getMaxHumidity(); editMode = true; break;
-      case MENU_HYSTERESIS: editValue = storage->getHysteresis(); editMode = true; break;
-      case MENU_CALIBRATE: calibrationMode = true; calibrationStep = 0; tempCalValue = storage->getTempCalibration(); humCalValue = storage->getHumCalibration(); break;
-      case MENU_WATER_THRESHOLD: waterCalMode = true; waterThreshold = storage->getWaterThreshold(); break;
-      case MENU_MANUAL: manualMode = true; manualState = humidifier->isRunning(); humidifier->toggle(); break;
-      case MENU_DISPLAY: displaySettingsMode = true; displaySubItem = 0; break;
-      case MENU_RESET_STATS: storage->resetWorkTime(); storage->resetSwitchCount(); storage->save(); break;
-      case MENU_ABOUT: aboutMode = true; break;
-      case MENU_EXIT: close(); break;
+  void runAction(uint8_t action) {
+    switch (action) {
+      case ACTION_RESET_STATS:
+        storage->resetWorkTime();
+        storage->resetSwitchCount();
+        storage->save();
+        break;
+      case ACTION_EXIT:
+        close();
+        break;
+      case ACTION_BRIGHTNESS:
+        if (display->getBrightness() == BRIGHTNESS_FULL) display->setBrightness(BRIGHTNESS_DIM1);
+        else display->setBrightness(BRIGHTNESS_FULL);
+        break;
+      case ACTION_BACK:
+        listId = MENU_LIST_MAIN;
+        currentItem = parentItem;
+        shownStart = -1;
+        break;
     }
   }
 
+  // Прошлый кадр еще уходит на шину - рисовать рано: clear() дописал
+  // бы его с ожиданием. Повороты, пришедшие за это время, сводятся в
+  // одну перерисовку
   void draw() {
-    if (!active || !needRedraw) return;
+    if (!active || !needRedraw || display->isBusy()) return;
     needRedraw = false;
+    // Любой другой экран затирает список
+    if (screen != SCREEN_LIST) shownStart = -1;
+    if (screen != SCREEN_DIAGNOSTICS) diagPass = 0;
 
-    if (calibrationMode) {
-      display->drawCalibrationScreen(sensor->getTemperature(), sensor->getHumidity(), tempCalValue, humCalValue, (calibrationStep == 0));
-      return;
-    }
-    
-    if (waterCalMode) {
-      int currentWater = 0;
-      uint8_t waterPercent = 0;
-      bool waterPresent = false;
-      
-      if (analytics) {
-        currentWater = analytics->getWaterRawValue();
-        waterPercent = analytics->getWaterPercent();
-        waterPresent = analytics->isWaterSensorPresent();
+    switch (screen) {
+      case SCREEN_EDIT:
+        drawEditScreen();
+        break;
+
+      case SCREEN_CALIBRATE:
+        display->drawCalibrationScreen(sensor->getTemperature(), sensor->getHumidity(),
+                                       values[0], values[1], valueIndex == 0);
+        break;
+
+      case SCREEN_WATER: {
+        int currentWater = 0;
+        uint8_t waterPercent = 0;
+        bool waterPresent = false;
+
+        if (analytics) {
+          currentWater = analytics->getWaterRawValue();
+          waterPercent = analytics->getWaterPercent();
+          waterPresent = analytics->isWaterSensorPresent();
+        }
+
+        display->drawWaterCalibrationScreen(currentWater, values[0], waterPresent, waterPercent);
+        break;
       }
-      
-      display->drawWaterCalibrationScreen(currentWater, waterThreshold, waterPresent, waterPercent);
-      return;
-    }
-    
-    if (manualMode) {
-      display->drawManualScreen(manualState);
-      return;
-    }
-    
-    if (displaySettingsMode) {
-      drawDisplaySettingsScreen();
-      return;
+
+      case SCREEN_MANUAL:
+        display->drawManualScreen(manualState);
+        break;
+
+      case SCREEN_ABOUT: {
+        uint16_t threshold = storage->getWaterThreshold();
+        display->drawAboutScreen(storage->getWorkTime(), humidifier->getSwitchCount(), storage->getTotalSwitches(), true, threshold, threshold - 50);
+        break;
+      }
+
+      case SCREEN_DIAGNOSTICS:
+        drawDiagnosticsScreen();
+        break;
+
+      case SCREEN_MEMORY:
+        drawMemoryScreen();
+        break;
+
+      default:
+        updateMenuScreen();
+        break;
     }
-    
-    if (aboutMode) {
-      display->drawAboutScreen(storage->getWorkTime(), humidifier->getSwitchCount(), storage->getTotalSwitches(), true, waterThreshold, waterThreshold - 50);
-      return;
+  }
+
+  // Первый видимый пункт: курсор по возможности в середине окна
+  int8_t menuStart() const {
+    int8_t startItem = currentItem - 2;
+    if (startItem < 0) startItem = 0;
+    if (startItem > listCount() - MENU_ROWS) startItem = listCount() - MENU_ROWS;
+    if (startItem < 0) startItem = 0;
+    return startItem;
+  }
+
+  // Строка пункта: курсор, название и значение у выбранного
+  void printMenuRow(uint8_t itemIndex, uint8_t startItem) {
+    MenuListDesc list;
+    MenuItemDesc item;
+    readList(listId, list);
+    readItem(list.items, itemIndex, item);
+
+    uint8_t y = 2 + itemIndex - startItem;
+    bool selected = itemIndex == currentItem;
+    if (selected) { display->setCursor(0, y); display->print(F(">")); }
+    display->setCursor(10, y);
+    display->print(uiStr(item.label));
+
+    if (selected && item.type == ITEM_ACTION && item.link == ACTION_BRIGHTNESS) {
+      display->setCursor(90, y);
+      uint8_t b = display->getBrightness();
+      if (b == BRIGHTNESS_FULL) display->print(F("100%"));
+      else if (b == BRIGHTNESS_DIM1) display->print(F("75%"));
+      else display->print(F("20%"));
     }
-    
-    if (editMode) { drawEditScreen(); return; }
-    
-    drawMenuScreen();
   }
 
   void drawMenuScreen() {
+    MenuListDesc list;
+    readList(listId, list);
+
     display->clear();
     display->setScale(1);
-    display->setCursor(40, 0);
-    display->print("MENU");
+    display->setCursor(list.titleX, 0);
+    display->print(uiStr(list.title));
     display->drawLine(0, 10, 127, 10);
 
-    int8_t startItem = currentItem - 2;
-    if (startItem < 0) startItem = 0;
-    if (startItem > MENU_COUNT - 5) startItem = MENU_COUNT - 5;
-    if (startItem < 0) startItem = 0;
-
-    for (uint8_t i = 0; i < 5; i++) {
+    int8_t startItem = menuStart();
+    for (uint8_t i = 0; i < MENU_ROWS; i++) {
       uint8_t itemIndex = startItem + i;
-      if (itemIndex >= MENU_COUNT) break;
-      uint8_t y = 2 + i;
-      if (itemIndex == currentItem) { display->setCursor(0, y); display->print(">"); }
-      display->setCursor(10, y);
-      display->print(menuItems[itemIndex]);
+      if (itemIndex >= list.count) break;
+      printMenuRow(itemIndex, startItem);
     }
 
     display->setCursor(0, 7);
-    display->print("R-вперед L-наз. DC-exit");
+    display->print(uiStr(list.hint));
     display->update();
+
+    shownStart = startItem;
+    shownItem = currentItem;
+  }
+
+  // Список после поворота: курсор сдвинулся внутри окна - две строки,
+  // окно прокрутилось - строки пунктов. Заголовок и подсказка остаются.
+  // Нажатие на пункт без своего экрана (яркость) - строка пункта
+  void updateMenuScreen() {
+    int8_t startItem = menuStart();
+    if (shownStart < 0) {
+      drawMenuScreen();
+      return;
+    }
+
+    display->clear();
+    display->setScale(1);
+    uint8_t pages;
+    if (startItem == shownStart) {
+      printMenuRow(currentItem, startItem);
+      pages = 1 << (2 + currentItem - startItem);
+      if (shownItem != currentItem) {
+        printMenuRow(shownItem, startItem);
+        pages |= 1 << (2 + shownItem - startItem);
+      }
+    } else {
+      for (uint8_t i = 0; i < MENU_ROWS && startItem + i < listCount(); i++)
+        printMenuRow(startItem + i, startItem);
+      pages = ((1 << MENU_ROWS) - 1) << 2;
+    }
+    display->updatePages(pages);
+
+    shownStart = startItem;
+    shownItem = currentItem;
   }
 
   void drawEditScreen() {
+    MenuItemDesc item;
+    readCurrent(item);
+
     display->clear();
     display->setScale(1);
     display->setCursor(20, 0);
-    display->print("НАСТРОЙКА");
+    display->print(STR_EDIT_TITLE);
     display->drawLine(0, 10, 127, 10);
     display->setCursor(0, 2);
-    display->print(menuItems[currentItem]);
+    display->print(uiStr(item.label));
     display->setScale(3);
     display->setCursor(35, 3);
-    display->print(editValue);
+    display->print(values[0]);
     display->setScale(1);
-    if (currentItem <= MENU_HYSTERESIS) { display->setCursor(95, 5); display->print("%"); }
+    if (item.unit) { display->setCursor(95, 5); display->print(flash(item.unit)); }
     display->setCursor(0, 7);
-    display->print("R+/- L-наз. CLICK-ок");
+    display->print(STR_EDIT_HINT);
     display->update();
   }
 
-  void drawDisplaySettingsScreen() {
+  // Время выполнения участков: среднее/максимум, мкс. Строка - до 6
+  // операций холста (число больше 32767 - две), и все строки с
+  // заголовком в список не помещаются: страница уходит в два прохода,
+  // второй - следующим draw(), когда первый уйдет на шину
+  void drawDiagnosticsScreen() {
+    const uint8_t half = PROF_COUNT / 2;
     display->clear();
     display->setScale(1);
-    display->setCursor(25, 0);
-    display->print("ДИСПЛЕЙ");
-    display->drawLine(0, 10, 127, 10);
 
-    for (uint8_t i = 0; i < 3; i++) {
+    if (!profiler) {
+      display->setCursor(20, 0);
+      display->print(STR_DIAG_TITLE);
+      display->drawLine(0, 10, 127, 10);
+      display->setCursor(0, 3);
+      display->print(STR_NO_DATA);
+      display->update();
+      return;
+    }
+
+    uint8_t first = diagPass ? half : 0;
+    uint8_t last = diagPass ? PROF_COUNT : half;
+    if (!diagPass) {
+      lastDiagDraw = millis();
+      display->setCursor(20, 0);
+      display->print(STR_DIAG_TITLE);
+      display->drawLine(0, 10, 127, 10);
+    }
+    for (uint8_t i = first; i < last; i++) {
       uint8_t y = 2 + i;
-      if (i == displaySubItem) { display->setCursor(0, y); display->print(">"); }
-      display->setCursor(10, y);
-      display->print(displayMenuItems[i]);
+      display->setCursor(0, y);
+      display->print(Profiler::getName(i));
+      display->setCursor(30, y);
+      display->print(profiler->getAvg(i));
+      display->print(F("/"));
+      display->print(profiler->getMax(i));
     }
 
-    if (displaySubItem == 0) {
-      display->setCursor(90, 2);
-      uint8_t b = display->getBrightness();
-      if (b == BRIGHTNESS_FULL) display->print("100%");
-      else if (b == BRIGHTNESS_DIM1) display->print("75%");
-      else display->print("20%");
+    // Страницы 0..1 - заголовок, строка i - страница 2 + i
+    uint8_t pages = (uint8_t)(0xFF << (2 + first)) & (uint8_t)~(0xFF << (2 + last));
+    if (!diagPass) pages |= 0x03;
+    display->updatePages(pages);
+    diagPass = !diagPass;
+    if (diagPass) needRedraw = true;
+  }
+
+  // Стек и свободная SRAM, байт; ниже - самые большие объекты модулей
+  void drawMemoryScreen() {
+    lastDiagDraw = millis();
+    display->clear();
+    display->setScale(1);
+    display->setCursor(30, 0);
+    display->print(STR_MEMORY_TITLE);
+    display->drawLine(0, 10, 127, 10);
+
+    if (!memory) {
+      display->setCursor(0, 3);
+      display->print(STR_NO_DATA);
+      display->update();
+      return;
     }
 
-    display->setCursor(0, 7);
-    display->print("L-назад");
+    memory->check();
+    display->setCursor(0, 2);
+    display->print(STR_STACK);
+    display->print((unsigned long)memory->getStackMax());
+    display->setCursor(64, 2);
+    display->print(STR_FREE);
+    display->print((unsigned long)memory->getFree());
+    display->setCursor(0, 3);
+    display->print(STR_SPARE);
+    display->print((unsigned long)memory->getSpare());
+    display->setCursor(64, 3);
+    display->print(STR_STATIC);
+    display->print((unsigned long)memory->getStaticBytes());
+    display->setCursor(0, 4);
+    display->print(STR_MODULES);
+    display->print((unsigned long)memory->getModulesBytes());
+
+    // Четыре самых больших, по два в строке
+    for (uint8_t rank = 0; rank < 4 && rank < memory->getModuleCount(); rank++) {
+      uint8_t i = memory->getLargest(rank);
+      uint8_t x = (rank & 1) ? 64 : 0;
+      uint8_t y = 5 + rank / 2;
+      display->setCursor(x, y);
+      display->print(memory->getModuleName(i));
+      display->setCursor(x + 36, y);
+      display->print((unsigned long)memory->getModuleSize(i));
+    }
     display->update();
   }
 };
@@ -0,0 +1,86 @@
+/*
+ * МОДУЛЬ ЭНЕРГОСБЕРЕЖЕНИЯ
+ * Сон SLEEP_MODE_IDLE между задачами планировщика.
+ * Будят прерывания Timer0 (millis, ~1 мс), энкодер, DHT22, TWI, UART.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include "hal.h"
+#include "config.h"
+
+typedef bool (*WakeCheck)();
+
+class Power {
+private:
+  unsigned long windowStart;   // Начало окна измерения, мкс
+  unsigned long sleepUs;       // Время сна в текущем окне, мкс
+  uint16_t awakePermille;      // Доля бодрствования за прошлое окно, ‰
+
+  void updateWindow() {
+    unsigned long now = micros();
+    unsigned long elapsed = now - windowStart;
+    if (elapsed < POWER_STATS_WINDOW * 1000UL) return;
+
+    // Считаем в мс, чтобы не переполнить 32 бита
+    unsigned long sleepMs = sleepUs / 1000;
+    unsigned long elapsedMs = elapsed / 1000;
+    if (sleepMs > elapsedMs) sleepMs = elapsedMs;
+    awakePermille = 1000 - (sleepMs * 1000 / elapsedMs);
+
+    windowStart = now;
+    sleepUs = 0;
+  }
+
+public:
+  Power() : windowStart(0), sleepUs(0), awakePermille(1000) {}
+
+  void begin() {
+    // Неиспользуемая периферия: SPI, Timer1, Timer2
+    power_spi_disable();
+    power_timer1_disable();
+    power_timer2_disable();
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    windowStart = micros();
+  }
+
+  // Сон до истечения waitMs или до wake() == true.
+  // Ограничен POWER_MAX_SLEEP, чтобы loop() успевал сбрасывать watchdog
+  void idle(unsigned long waitMs, WakeCheck wake) {
+    if (waitMs > POWER_MAX_SLEEP) waitMs = POWER_MAX_SLEEP;
+
+    unsigned long start = millis();
+    while (millis() - start < waitMs) {
+      // Проверка и засыпание атомарно: команда после sei выполняется
+      // до обработки прерываний, поэтому событие не теряется до сна
+      noInterrupts();
+      if (wake && wake()) {
+        interrupts();
+        break;
+      }
+      unsigned long before = micros();
+      sleep_enable();
+      interrupts();
+      sleep_cpu();
+      sleep_disable();
+      sleepUs += micros() - before;
+    }
+
+    updateWindow();
+  }
+
+  // Доля времени бодрствования за последнее окно, десятые доли %
+  uint16_t getAwakePermille() const { return awakePermille; }
+
+  void printStats(Print& out) const {
+    out.print(F("AWAKE: "));
+    out.print(awakePermille / 10);
+    out.print('.');
+    out.print(awakePermille % 10);
+    out.println(F("%"));
+  }
+};
+
+#endif // POWER_H
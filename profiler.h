@@ -0,0 +1,161 @@
+/*
+ * МОДУЛЬ ПРОФИЛИРОВАНИЯ
+ * Замер времени выполнения участков кода по micros():
+ * min/avg/max и гистограмма по степеням двойки
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "hal.h"
+#include "config.h"
+
+enum ProfileSection {
+  PROF_LOOP = 0,       // Один проход loop()
+  PROF_SENSOR = 1,     // sensor.update()
+  PROF_DRAW_MAIN = 2,  // display.drawMainScreen()
+  PROF_DRAW_MENU = 3,  // menu.draw()
+  PROF_WATER = 4,      // analytics.checkWaterLevel()
+  PROF_SAVE = 5,       // storage.saveDirect()
+  PROF_COUNT = 6
+};
+
+// Корзина k гистограммы: [2^(k+4), 2^(k+5)) мкс, первая - всё что меньше 32 мкс,
+// последняя - всё что больше
+#define PROFILER_MIN_SHIFT 5
+
+struct SectionStats {
+  unsigned long minUs;
+  unsigned long maxUs;
+  unsigned long sumUs;
+  uint16_t count;
+  uint8_t hist[PROFILER_BUCKETS];
+};
+
+class Profiler {
+private:
+  SectionStats stats[PROF_COUNT];
+
+  static uint8_t bucketOf(unsigned long us) {
+    uint8_t b = 0;
+    us >>= PROFILER_MIN_SHIFT;
+    while (us && b < PROFILER_BUCKETS - 1) {
+      us >>= 1;
+      b++;
+    }
+    return b;
+  }
+
+public:
+  Profiler() { reset(); }
+
+  void reset() {
+    for (uint8_t i = 0; i < PROF_COUNT; i++) {
+      memset(&stats[i], 0, sizeof(SectionStats));
+      stats[i].minUs = 0xFFFFFFFF;
+    }
+  }
+
+  void record(uint8_t section, unsigned long us) {
+    if (section >= PROF_COUNT) return;
+    SectionStats& s = stats[section];
+
+    if (us < s.minUs) s.minUs = us;
+    if (us > s.maxUs) s.maxUs = us;
+
+    // Перед переполнением делим сумму и счетчик пополам - среднее сохраняется
+    if (s.count == 0xFFFF || s.sumUs > 0x7FFFFFFF) {
+      s.sumUs >>= 1;
+      s.count >>= 1;
+    }
+    s.sumUs += us;
+    s.count++;
+
+    // Насыщающиеся 8-битные счетчики: при переполнении масштабируем всю гистограмму
+    uint8_t b = bucketOf(us);
+    if (s.hist[b] == 255) {
+      for (uint8_t i = 0; i < PROFILER_BUCKETS; i++) s.hist[i] >>= 1;
+    }
+    s.hist[b]++;
+  }
+
+  unsigned long getMin(uint8_t section) const {
+    return stats[section].count ? stats[section].minUs : 0;
+  }
+
+  unsigned long getMax(uint8_t section) const {
+    return stats[section].maxUs;
+  }
+
+  unsigned long getAvg(uint8_t section) const {
+    return stats[section].count ? stats[section].sumUs / stats[section].count : 0;
+  }
+
+  uint16_t getCount(uint8_t section) const {
+    return stats[section].count;
+  }
+
+  const uint8_t* getHistogram(uint8_t section) const {
+    return stats[section].hist;
+  }
+
+  static const __FlashStringHelper* getName(uint8_t section) {
+    switch (section) {
+      case PROF_LOOP: return F("LOOP");
+      case PROF_SENSOR: return F("SENS");
+      case PROF_DRAW_MAIN: return F("MAIN");
+      case PROF_DRAW_MENU: return F("MENU");
+      case PROF_WATER: return F("WATR");
+      case PROF_SAVE: return F("SAVE");
+    }
+    return F("?");
+  }
+
+  // Вывод полной статистики в Serial
+  void dump(Print& out) const {
+    out.println(F("=== DIAG, us ==="));
+    for (uint8_t i = 0; i < PROF_COUNT; i++) {
+      out.print(getName(i));
+      out.print(F(" n=")); out.print(getCount(i));
+      out.print(F(" min=")); out.print(getMin(i));
+      out.print(F(" avg=")); out.print(getAvg(i));
+      out.print(F(" max=")); out.println(getMax(i));
+
+      out.print(F("  "));
+      for (uint8_t b = 0; b < PROFILER_BUCKETS; b++) {
+        if (stats[i].hist[b] == 0) continue;
+        out.print(b == PROFILER_BUCKETS - 1 ? '>' : '<');
+        out.print(b == PROFILER_BUCKETS - 1 ? (1UL << (b + PROFILER_MIN_SHIFT - 1))
+                                            : (1UL << (b + PROFILER_MIN_SHIFT)));
+        out.print(':');
+        out.print(stats[i].hist[b]);
+        out.print(' ');
+      }
+      out.println();
+    }
+  }
+};
+
+// Замер участка от создания до выхода из области видимости
+class ProfileScope {
+private:
+  Profiler& profiler;
+  uint8_t section;
+  unsigned long start;
+
+public:
+  ProfileScope(Profiler& prof, uint8_t sect)
+    : profiler(prof), section(sect), start(micros()) {}
+
+  ~ProfileScope() {
+    profiler.record(section, micros() - start);
+  }
+};
+
+#if PROFILER_ENABLED
+  #define PROFILE_SCOPE(section) ProfileScope profileScope_(profiler, section)
+#else
+  #define PROFILE_SCOPE(section)
+#endif
+
+#endif // PROFILER_H
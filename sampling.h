@@ -0,0 +1,83 @@
+/*
+ * АДАПТИВНЫЙ ПЕРИОД ЗАМЕРА
+ * Большую часть дня влажность стоит посреди полосы уставок, и замер
+ * раз в 2 с только будит процессор и гоняет шину. Период круга
+ * замеров (sensor.h) и управления выбирается по последнему замеру:
+ *   - у порога (ближе SAMPLE_NEAR_BAND), за порогом или при быстром
+ *     изменении (от SAMPLE_FAST_RATE) - самый частый, UPDATE_INTERVAL;
+ *   - иначе - чтобы до порога при нынешней скорости оставалось не
+ *     меньше SAMPLE_HORIZON замеров, но не реже SAMPLE_INTERVAL_MAX.
+ * Ускорение - сразу, замедление - не больше чем вдвое за замер.
+ * Скорость - по отфильтрованной влажности за окно SAMPLE_RATE_WINDOW:
+ * шум DHT22 между соседними замерами за изменение не принимается
+ */
+
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include "hal.h"
+#include "config.h"
+#include "fixed.h"
+#include "log.h"
+
+class SampleRate {
+private:
+  unsigned long interval;
+  unsigned long anchorTime;   // Начало окна оценки скорости
+  Deci anchorHum;
+  bool anchored;
+  uint16_t rate;              // Модуль скорости, 0,1 %/мин
+
+public:
+  SampleRate() : interval(UPDATE_INTERVAL), anchorTime(0), anchorHum(0),
+                 anchored(false), rate(0) {}
+
+  // Период до следующего круга замеров, мс. hum - отфильтрованная
+  // влажность, minHum/maxHum - уставки, %
+  unsigned long update(Deci hum, uint8_t minHum, uint8_t maxHum, bool sensorOK) {
+    unsigned long now = millis();
+
+    // Без замера скорость неизвестна: часто, чтобы быстрее заметить
+    // восстановление или отказ
+    if (!sensorOK) {
+      anchored = false;
+      rate = 0;
+      interval = UPDATE_INTERVAL;
+      return interval;
+    }
+
+    if (!anchored) {
+      anchorTime = now;
+      anchorHum = hum;
+      anchored = true;
+    } else if (now - anchorTime >= SAMPLE_RATE_WINDOW) {
+      uint32_t r = (uint32_t)abs(hum - anchorHum) * 60000UL / (now - anchorTime);
+      rate = r > 0xFFFF ? 0xFFFF : r;
+      anchorTime = now;
+      anchorHum = hum;
+    }
+
+    // До ближайшего порога: 0 и меньше - уже за ним
+    Deci dist = min((Deci)(hum - deciFromInt(minHum)), (Deci)(deciFromInt(maxHum) - hum));
+
+    unsigned long target;
+    if (dist <= SAMPLE_NEAR_BAND || rate >= SAMPLE_FAST_RATE) {
+      target = UPDATE_INTERVAL;
+    } else if (rate == 0) {
+      target = SAMPLE_INTERVAL_MAX;
+    } else {
+      target = (uint32_t)dist * 60000UL / rate / SAMPLE_HORIZON;
+    }
+
+    unsigned long next = min(target, interval * 2);
+    next = constrain(next, (unsigned long)UPDATE_INTERVAL, (unsigned long)SAMPLE_INTERVAL_MAX);
+    if (next != interval) LOG_D("SMPL", "%lu ms (d=%d r=%u)", next, dist, rate);
+    interval = next;
+    return interval;
+  }
+
+  unsigned long getInterval() const { return interval; }
+  uint16_t getRate() const { return rate; }
+};
+
+#endif // SAMPLING_H
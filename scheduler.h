@@ -0,0 +1,106 @@
+/*
+ * МОДУЛЬ ПЛАНИРОВЩИКА ЗАДАЧ
+ * Кооперативный планировщик со статической таблицей задач
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "hal.h"
+#include "config.h"
+
+typedef void (*TaskCallback)();
+
+struct Task {
+  TaskCallback callback;
+  unsigned long period;     // Период запуска, мс
+  unsigned long nextRun;    // Срок следующего запуска (millis)
+#if PROFILER_ENABLED
+  unsigned long runTime;    // Длительность последнего запуска, мкс
+  unsigned long maxRunTime; // Максимальная длительность, мкс
+#endif
+  bool enabled;
+};
+
+class Scheduler {
+private:
+  Task tasks[SCHEDULER_MAX_TASKS];
+  uint8_t taskCount;
+
+public:
+  Scheduler() : taskCount(0) {}
+
+  // Регистрация задачи. Возвращает номер задачи или -1, если таблица заполнена
+  int8_t addTask(TaskCallback callback, unsigned long period, unsigned long startDelay = 0) {
+    if (taskCount >= SCHEDULER_MAX_TASKS) return -1;
+
+    Task& t = tasks[taskCount];
+    t.callback = callback;
+    t.period = period;
+    t.nextRun = millis() + startDelay;
+#if PROFILER_ENABLED
+    t.runTime = 0;
+    t.maxRunTime = 0;
+#endif
+    t.enabled = true;
+
+    return taskCount++;
+  }
+
+  // Выполнение всех задач, срок которых наступил (вызывать в loop)
+  void tick() {
+    for (uint8_t i = 0; i < taskCount; i++) {
+      Task& t = tasks[i];
+      if (!t.enabled) continue;
+
+      unsigned long now = millis();
+      if ((long)(now - t.nextRun) < 0) continue;
+
+      // Следующий срок считаем от предыдущего, чтобы период не "уплывал".
+      // При сильном опоздании не догоняем пропущенные запуски.
+      t.nextRun += t.period;
+      if ((long)(now - t.nextRun) >= 0) t.nextRun = now + t.period;
+
+#if PROFILER_ENABLED
+      unsigned long start = micros();
+      t.callback();
+      t.runTime = micros() - start;
+      if (t.runTime > t.maxRunTime) t.maxRunTime = t.runTime;
+#else
+      t.callback();
+#endif
+    }
+  }
+
+  // Время до ближайшего срока, мс (0 - есть просроченная задача)
+  unsigned long timeToNext() const {
+    unsigned long now = millis();
+    unsigned long wait = 0xFFFFFFFF;
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+      if (!tasks[i].enabled) continue;
+      long left = (long)(tasks[i].nextRun - now);
+      if (left <= 0) return 0;
+      if ((unsigned long)left < wait) wait = left;
+    }
+    return wait;
+  }
+
+  // Перенос следующего запуска задачи (можно вызывать из самой задачи)
+  void runIn(uint8_t id, unsigned long delayMs) {
+    if (id < taskCount) tasks[id].nextRun = millis() + delayMs;
+  }
+
+  void setPeriod(uint8_t id, unsigned long period) {
+    if (id < taskCount) tasks[id].period = period;
+  }
+
+  void setEnabled(uint8_t id, bool enabled) {
+    if (id < taskCount) tasks[id].enabled = enabled;
+  }
+
+  uint8_t getTaskCount() const { return taskCount; }
+  const Task& getTask(uint8_t id) const { return tasks[id]; }
+};
+
+#endif // SCHEDULER_H
@@ -1,39 +1,168 @@
 /*
- * МОДУЛЬ ДАТЧИКА DHT22
- * Чтение температуры и влажности
+ * МОДУЛЬ ДАТЧИКОВ ТЕМПЕРАТУРЫ И ВЛАЖНОСТИ
+ * Чтение без блокировки loop() через драйверы (sensor_driver.h):
+ * до SENSOR_MAX датчиков DHT22, SHT31 и BME280 вперемешку. Датчики
+ * опрашиваются по кругу, по одному за шаг: в каждый момент замер
+ * ведет только один - линию DHT22 или шину I2C занимает он один.
+ * За круг (readInterval) каждый датчик измеряет по разу, затем
+ * показания сводятся в одно значение для комнаты: медиана, выбросы
+ * дальше SENSOR_OUTLIER_* от нее отбрасываются, остальные
+ * усредняются. Калибровка - к сводному значению.
+ * Значения в десятых долях (fixed.h).
+ * Влажность для управления дополнительно проходит фильтр (filter.h)
  */
 
 #ifndef SENSOR_H
 #define SENSOR_H
 
-#include <Arduino.h>
-#include <DHT.h>
+#include "hal.h"
 #include "config.h"
+#include "sensor_driver.h"
+#include "fixed.h"
+#include "filter.h"
+#include "log.h"
 #include "storage.h"
 
+// Состояние одного датчика по последнему замеру
+enum SensorHealth {
+  SENSOR_HEALTH_NONE = 0,     // Замеров еще не было
+  SENSOR_HEALTH_OK = 1,
+  SENSOR_HEALTH_OUTLIER = 2,  // Замер есть, но далеко от остальных
+  SENSOR_HEALTH_ERROR = 3     // Ошибка обмена или значение вне диапазона
+};
+
+struct SensorSlot {
+  SensorDriver* driver;
+  const __FlashStringHelper* name;
+  Deci temperature;           // Последний удачный замер, без калибровки
+  Deci humidity;
+  uint8_t health;
+  uint8_t errorCount;
+};
+
 class Sensor {
 private:
-  DHT dht;
-  float temperature;
-  float humidity;
-  float rawTemperature;
-  float rawHumidity;
+  SensorSlot slots[SENSOR_MAX];
+  uint8_t count;
+  uint8_t current;            // Чей замер идет или следующий
+  uint8_t rounds;             // Завершенных кругов, по модулю 256
+  Deci temperature;
+  Deci humidity;
+  Deci rawTemperature;
+  Deci rawHumidity;
+  HumidityFilter humFilter;
   bool lastReadSuccess;
+  bool measuring;
   unsigned long lastReadTime;
+  unsigned long readInterval;
   uint8_t errorCount;
   uint8_t consecutiveErrors;
-  
+
   // Указатель на storage для калибровки
   Storage* storage;
 
+  // Замер датчика current завершен с результатом result
+  void record(uint8_t result) {
+    SensorSlot& slot = slots[current];
+    if (result == SENSOR_OK) {
+      Deci t = slot.driver->getTemperature();
+      Deci h = slot.driver->getHumidity();
+      // Проверка диапазона значений
+      if (t >= DECI(-40) && t <= DECI(80) && h >= 0 && h <= DECI(100)) {
+        slot.temperature = t;
+        slot.humidity = h;
+        slot.health = SENSOR_HEALTH_OK;
+        return;
+      }
+      LOG_W("SENS", "%d out of range", current);
+    } else {
+      LOG_W("SENS", "%d read error %d", current, result);
+    }
+    slot.health = SENSOR_HEALTH_ERROR;
+    if (slot.errorCount < 255) slot.errorCount++;
+  }
+
+  // Средний по порядку элемент (нижний из двух при четном n)
+  static Deci median(Deci* v, uint8_t n) {
+    for (uint8_t i = 1; i < n; i++) {
+      Deci x = v[i];
+      uint8_t j = i;
+      for (; j > 0 && v[j - 1] > x; j--) v[j] = v[j - 1];
+      v[j] = x;
+    }
+    return v[(n - 1) / 2];
+  }
+
+  static Deci average(int16_t sum, uint8_t n) {
+    return (sum + (sum < 0 ? -(int16_t)n / 2 : n / 2)) / n;
+  }
+
+  // Круг завершен: сводное значение из исправных датчиков.
+  // false - исправных нет
+  bool fuse(Deci& t, Deci& h) {
+    Deci temps[SENSOR_MAX], hums[SENSOR_MAX];
+    uint8_t valid = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      if (slots[i].health == SENSOR_HEALTH_ERROR || slots[i].health == SENSOR_HEALTH_NONE) continue;
+      temps[valid] = slots[i].temperature;
+      hums[valid] = slots[i].humidity;
+      valid++;
+    }
+    if (valid == 0) return false;
+
+    // С одним-двумя датчиками не понять, кто врет: просто среднее
+    bool reject = valid >= SENSOR_OUTLIER_MIN;
+    Deci medT = median(temps, valid);
+    Deci medH = median(hums, valid);
+
+    int16_t sumT = 0, sumH = 0;
+    uint8_t used = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      SensorSlot& slot = slots[i];
+      if (slot.health == SENSOR_HEALTH_ERROR || slot.health == SENSOR_HEALTH_NONE) continue;
+      if (reject && (abs(slot.temperature - medT) > SENSOR_OUTLIER_TEMP ||
+                     abs(slot.humidity - medH) > SENSOR_OUTLIER_HUM)) {
+        slot.health = SENSOR_HEALTH_OUTLIER;
+        continue;
+      }
+      slot.health = SENSOR_HEALTH_OK;
+      sumT += slot.temperature;
+      sumH += slot.humidity;
+      used++;
+    }
+    // Медиана - сам замер и себе не выброс: used >= 1
+    t = average(sumT, used);
+    h = average(sumH, used);
+    return true;
+  }
+
+  // Интервал между замерами соседних датчиков
+  unsigned long getSlotInterval() const {
+    return count ? readInterval / count : readInterval;
+  }
+
+  // Пауза перед замером датчика current. Первый его замер - не раньше
+  // minInterval драйвера: DHT22 после включения ~2 с не отвечает, а
+  // доля круга на датчик бывает вдвое короче
+  unsigned long getWaitInterval() const {
+    unsigned long wait = getSlotInterval();
+    if (slots[current].health == SENSOR_HEALTH_NONE)
+      wait = max(wait, (unsigned long)slots[current].driver->getMinInterval());
+    return wait;
+  }
+
 public:
-  Sensor() : dht(DHT_PIN, DHT_TYPE), 
-             temperature(0), 
+  Sensor() : count(0),
+             current(0),
+             rounds(0),
+             temperature(0),
              humidity(0),
              rawTemperature(0),
              rawHumidity(0),
              lastReadSuccess(false),
+             measuring(false),
              lastReadTime(0),
+             readInterval(UPDATE_INTERVAL),
              errorCount(0),
              consecutiveErrors(0),
              storage(nullptr) {}
@@ -43,35 +172,52 @@ public:
     storage = stor;
   }
 
-  // Инициализация датчика
-  void begin() {
-    dht.begin();
-    delay(2000); // DHT22 требует задержку после инициализации
+  // Датчик в круг опроса, до begin(). Драйвер уже запущен своим
+  // begin(), name - во flash. false - мест нет
+  bool addDriver(SensorDriver* drv, const __FlashStringHelper* name) {
+    if (count >= SENSOR_MAX) return false;
+    SensorSlot& slot = slots[count++];
+    slot.driver = drv;
+    slot.name = name;
+    slot.temperature = 0;
+    slot.humidity = 0;
+    slot.health = SENSOR_HEALTH_NONE;
+    slot.errorCount = 0;
+    return true;
   }
 
-  // Обновление данных с датчика
-  bool update() {
-    // Защита от слишком частого опроса
-    if (millis() - lastReadTime < 2000) {
-      return lastReadSuccess;
-    }
-
+  // Отсчет до первого замера - от begin() (getWaitInterval)
+  void begin() {
+    setReadInterval(readInterval);
     lastReadTime = millis();
+  }
 
-    // Чтение данных
-    float h = dht.readHumidity();
-    float t = dht.readTemperature();
+  // Шаг измерения, не блокирует. Возвращает true, когда завершен
+  // очередной круг измерения (результат - isOK() и геттеры)
+  bool update() {
+    if (count == 0) return false;
 
-    // Проверка корректности данных
-    if (isnan(h) || isnan(t)) {
-      handleError();
+    if (!measuring) {
+      if (millis() - lastReadTime < getWaitInterval()) return false;
+      if (slots[current].driver->start()) {
+        measuring = true;
+        lastReadTime = millis();
+      }
       return false;
     }
 
-    // Проверка диапазона значений
-    if (t < -40.0 || t > 80.0 || h < 0.0 || h > 100.0) {
+    uint8_t result = slots[current].driver->poll();
+    if (result == SENSOR_BUSY) return false;
+    measuring = false;
+    record(result);
+    if (++current < count) return false;
+    current = 0;
+    rounds++;
+
+    Deci t, h;
+    if (!fuse(t, h)) {
       handleError();
-      return false;
+      return true;
     }
 
     // Сохранение сырых значений
@@ -88,8 +234,9 @@ public:
     }
 
     // Ограничение в допустимых пределах
-    temperature = constrain(temperature, -40.0, 80.0);
-    humidity = constrain(humidity, 0.0, 100.0);
+    temperature = constrain(temperature, DECI(-40), DECI(80));
+    humidity = constrain(humidity, 0, DECI(100));
+    humFilter.add(humidity);
 
     // Успешное чтение
     consecutiveErrors = 0;
@@ -98,36 +245,62 @@ public:
     return true;
   }
 
-  // Обработка ошибки
+  // Через сколько мс нужно снова вызвать update()
+  unsigned long getPollDelay() const {
+    if (measuring) return slots[current].driver->getPollInterval();
+    unsigned long wait = getWaitInterval();
+    unsigned long elapsed = millis() - lastReadTime;
+    return elapsed >= wait ? 0 : wait - elapsed;
+  }
+
+  // Длительность круга опроса: не меньше, чем позволяет самый
+  // медленный датчик (каждый измеряет раз за круг)
+  void setReadInterval(unsigned long interval) {
+    readInterval = interval;
+    for (uint8_t i = 0; i < count; i++) {
+      readInterval = max(readInterval, (unsigned long)slots[i].driver->getMinInterval());
+    }
+  }
+
+  unsigned long getReadInterval() const { return readInterval; }
+
+  // Круг без единого исправного датчика
   void handleError() {
     consecutiveErrors++;
     if (errorCount < 255) {
       errorCount++;
     }
     lastReadSuccess = false;
+    // Датчики отказали: после восстановления фильтр начинает заново
+    if (consecutiveErrors == 3) humFilter.reset();
   }
 
-  // Получение температуры
-  float getTemperature() const {
+  // Сводная температура, 0,1 °C
+  Deci getTemperature() const {
     return temperature;
   }
 
-  // Получение влажности
-  float getHumidity() const {
+  // Сводная влажность, 0,1 %
+  Deci getHumidity() const {
     return humidity;
   }
 
+  // Влажность после фильтра - для управления, 0,1 %
+  Deci getFilteredHumidity() const {
+    return humFilter.get();
+  }
+
   // Получение сырой температуры (без калибровки)
-  float getRawTemperature() const {
+  Deci getRawTemperature() const {
     return rawTemperature;
   }
 
   // Получение сырой влажности (без калибровки)
-  float getRawHumidity() const {
+  Deci getRawHumidity() const {
     return rawHumidity;
   }
 
-  // Проверка состояния датчика
+  // Проверка состояния: есть сводное значение
   bool isOK() const {
     return lastReadSuccess && (consecutiveErrors < 3);
   }
@@ -137,7 +310,7 @@ public:
     return consecutiveErrors >= 5;
   }
 
-  // Получение количества ошибок
+  // Кругов без единого исправного датчика, всего
   uint8_t getErrorCount() const {
     return errorCount;
   }
@@ -151,7 +324,19 @@ public:
   void resetErrorCount() {
     errorCount = 0;
     consecutiveErrors = 0;
+    for (uint8_t i = 0; i < count; i++) slots[i].errorCount = 0;
   }
+
+  // Меняется с каждым завершенным кругом
+  uint8_t getRounds() const { return rounds; }
+
+  // Отдельные датчики: замеры без калибровки
+  uint8_t getCount() const { return count; }
+  const __FlashStringHelper* getName(uint8_t i) const { return slots[i].name; }
+  Deci getSensorTemperature(uint8_t i) const { return slots[i].temperature; }
+  Deci getSensorHumidity(uint8_t i) const { return slots[i].humidity; }
+  uint8_t getSensorHealth(uint8_t i) const { return slots[i].health; }
+  uint8_t getSensorErrors(uint8_t i) const { return slots[i].errorCount; }
 };
 
 #endif // SENSOR_H
@@ -0,0 +1,53 @@
+/*
+ * ИНТЕРФЕЙС ДРАЙВЕРА ДАТЧИКА ТЕМПЕРАТУРЫ И ВЛАЖНОСТИ
+ * Sensor (sensor.h) запускает одиночный замер через start() и
+ * опрашивает poll(), пока тот возвращает SENSOR_BUSY. Ни один шаг
+ * не ждет датчик: DHT22 (dht22.h) принимает биты в прерывании,
+ * SHT31 (sht3x.h) и BME280 (bme280.h) обмениваются через очередь
+ * I2C дисплея (twi.h). Значения - в десятых долях (fixed.h)
+ */
+
+#ifndef SENSOR_DRIVER_H
+#define SENSOR_DRIVER_H
+
+#include "hal.h"
+#include "fixed.h"
+
+enum SensorResult {
+  SENSOR_BUSY = 0,
+  SENSOR_OK = 1,
+  SENSOR_ERROR_TIMEOUT = 2,    // Датчик не ответил
+  SENSOR_ERROR_CHECKSUM = 3,
+  SENSOR_ERROR_BUS = 4         // NACK или ошибка шины I2C
+};
+
+class SensorDriver {
+private:
+  uint16_t minInterval;
+  uint8_t pollInterval;
+
+protected:
+  Deci temperature;
+  Deci humidity;
+
+  SensorDriver(uint16_t minMs, uint8_t pollMs)
+    : minInterval(minMs), pollInterval(pollMs), temperature(0), humidity(0) {}
+
+public:
+  // Начать замер. false - предыдущий еще не завершен
+  virtual bool start() = 0;
+
+  // Шаг автомата замера: SENSOR_BUSY, пока не завершен
+  virtual uint8_t poll() = 0;
+
+  // Результат последнего успешного замера
+  Deci getTemperature() const { return temperature; }
+  Deci getHumidity() const { return humidity; }
+
+  // Не чаще, мс между замерами
+  uint16_t getMinInterval() const { return minInterval; }
+  // Период poll() во время замера, мс
+  uint8_t getPollInterval() const { return pollInterval; }
+};
+
+#endif // SENSOR_DRIVER_H
@@ -0,0 +1,118 @@
+/*
+ * ДРАЙВЕР SHT31 (I2C)
+ * Одиночный замер высокой точности без удержания SCL: команда
+ * 0x2400, через SHT31_MEASURE_TIME - чтение 6 байт. Пока замер
+ * идет, датчик не отвечает на адрес (NACK) - чтение повторяется
+ * до SHT31_TIMEOUT. Обмен идет через очередь I2C дисплея (twi.h)
+ * и не ждет шину: пока в очереди нет места, шаг откладывается
+ */
+
+#ifndef SHT3X_H
+#define SHT3X_H
+
+#include "hal.h"
+#include "config.h"
+#include "sensor_driver.h"
+#include "twi.h"
+
+enum Sht3xState {
+  SHT3X_STATE_IDLE = 0,
+  SHT3X_STATE_START = 1,    // Команда ждет места в очереди
+  SHT3X_STATE_MEASURE = 2,  // Идет замер
+  SHT3X_STATE_READ = 3      // Чтение в очереди или на шине
+};
+
+class Sht3x : public SensorDriver {
+private:
+  TwiQueue* bus;
+  uint8_t data[6];          // T, CRC, RH, CRC - старший байт первым
+  uint8_t state;
+  unsigned long stateTime;  // Запуск замера - отсчет таймаута
+  unsigned long commandTime;
+
+  // CRC-8 из даташита: полином 0x31, начальное 0xFF
+  static uint8_t crc8(const uint8_t* bytes, uint8_t length) {
+    uint8_t crc = 0xFF;
+    while (length--) {
+      crc ^= *bytes++;
+      for (uint8_t i = 0; i < 8; i++) {
+        crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+      }
+    }
+    return crc;
+  }
+
+  uint8_t decode() {
+    if (crc8(data, 2) != data[2] || crc8(data + 3, 2) != data[5]) {
+      return SENSOR_ERROR_CHECKSUM;
+    }
+
+    // T = -45 + 175 * S / 65535 °C, RH = 100 * S / 65535 %:
+    // в десятых, деление на 65536 с округлением
+    uint16_t rawT = ((uint16_t)data[0] << 8) | data[1];
+    uint16_t rawH = ((uint16_t)data[3] << 8) | data[4];
+    temperature = (Deci)(((uint32_t)rawT * 1750 + 32768) >> 16) - 450;
+    humidity = (Deci)(((uint32_t)rawH * 1000 + 32768) >> 16);
+    return SENSOR_OK;
+  }
+
+public:
+  Sht3x() : SensorDriver(SHT31_MIN_INTERVAL, SHT31_POLL_INTERVAL),
+            bus(nullptr), state(SHT3X_STATE_IDLE), stateTime(0), commandTime(0) {}
+
+  // Шину запускает дисплей, до первого замера
+  void begin(TwiQueue* twi) {
+    bus = twi;
+  }
+
+  bool start() override {
+    if (state != SHT3X_STATE_IDLE || bus == nullptr) return false;
+    state = SHT3X_STATE_START;
+    stateTime = millis();
+    return true;
+  }
+
+  uint8_t poll() override {
+    if (state == SHT3X_STATE_IDLE) return SENSOR_BUSY;
+
+    if (millis() - stateTime >= SHT31_TIMEOUT) {
+      state = SHT3X_STATE_IDLE;
+      return SENSOR_ERROR_TIMEOUT;
+    }
+
+    switch (state) {
+      case SHT3X_STATE_START:
+        if (bus->space() < 4) return SENSOR_BUSY;
+        bus->beginTransmission(SHT31_ADDRESS);
+        bus->write(0x24);   // Высокая точность, без удержания SCL
+        bus->write(0x00);
+        bus->endTransmission();
+        commandTime = millis();
+        state = SHT3X_STATE_MEASURE;
+        return SENSOR_BUSY;
+
+      case SHT3X_STATE_MEASURE:
+        if (millis() - commandTime < SHT31_MEASURE_TIME) return SENSOR_BUSY;
+        if (bus->space() < 2 || !bus->requestFrom(SHT31_ADDRESS, data, sizeof(data))) {
+          return SENSOR_BUSY;
+        }
+        state = SHT3X_STATE_READ;
+        return SENSOR_BUSY;
+
+      case SHT3X_STATE_READ:
+        switch (bus->getReadState()) {
+          case TWI_READ_PENDING:
+            return SENSOR_BUSY;
+          case TWI_READ_DONE:
+            state = SHT3X_STATE_IDLE;
+            return decode();
+        }
+        // NACK: замер еще не готов, повтор на следующем шаге
+        state = SHT3X_STATE_MEASURE;
+        return SENSOR_BUSY;
+    }
+    return SENSOR_BUSY;
+  }
+};
+
+#endif // SHT3X_H
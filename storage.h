@@ -1,29 +1,31 @@
 /*
  * МОДУЛЬ ХРАНИНИЛИЩА НАСТРОЕК
- * Работа с EEPROM для сохранения параметров
+ * Работа с EEPROM для сохранения параметров.
+ * Поправки калибровки - десятые доли (fixed.h), 2 байта. Прежние
+ * версии хранили их во float: такой образ узнается по старому
+ * магическому числу и переводится без soft-float
  */
 
 #ifndef STORAGE_H
 #define STORAGE_H
 
-#include <Arduino.h>
-#include <EEPROM.h>
+#include "hal.h"
 #include "config.h"
+#include "fixed.h"
 
 class Storage {
 private:
   uint8_t minHumidity;
   uint8_t maxHumidity;
   uint8_t hysteresis;
-  float tempCalibration;
-  float humCalibration;
-  unsigned long workTime; // Время работы в секундах
-  unsigned long totalSwitches; // Общее количество переключений
+  Deci tempCalibration;     // 0,1 °C
+  Deci humCalibration;      // 0,1 %
+  uint32_t workTime; // Время работы в секундах
+  uint32_t totalSwitches; // Общее количество переключений
   uint16_t waterThreshold; // Порог датчика воды
   
   // Защита от износа EEPROM
   bool needsSave;
-  unsigned long lastSaveTime;
 
 public:
   Storage() : minHumidity(DEFAULT_MIN_HUMIDITY),
@@ -34,21 +36,24 @@ public:
               workTime(0),
               totalSwitches(0),
               waterThreshold(WATER_THRESHOLD),
-              needsSave(false),
-              lastSaveTime(0) {}
+              needsSave(false) {}
 
   // Инициализация и загрузка настроек
   void begin() {
     // Проверка магического числа
     uint8_t magic = EEPROM.read(EEPROM_MAGIC_ADDR);
 
-    if (magic != EEPROM_MAGIC_VALUE) {
+    if (magic == EEPROM_MAGIC_VALUE) {
+      // Загрузка настроек
+      load();
+    } else if (magic == EEPROM_MAGIC_FLOAT_CAL) {
+      // Образ прошлой версии: переводим калибровку и сохраняем
+      loadFloatCalibration();
+      saveDirect();
+    } else {
       // Первый запуск - инициализация EEPROM
       setDefaults();
       saveDirect();
-    } else {
-      // Загрузка настроек
-      load();
     }
   }
 
@@ -58,7 +63,7 @@ public:
     maxHumidity = EEPROM.read(EEPROM_MAX_HUM_ADDR);
     hysteresis = EEPROM.read(EEPROM_HYSTERESIS_ADDR);
 
-    // Загрузка калибровки (float = 4 байта)
+    // Загрузка калибровки (int16_t = 2 байта)
     EEPROM.get(EEPROM_TEMP_CAL_ADDR, tempCalibration);
     EEPROM.get(EEPROM_HUM_CAL_ADDR, humCalibration);
 
@@ -75,6 +80,27 @@ public:
     validateSettings();
   }
 
+  // Образ с калибровкой во float: остальные поля на тех же местах
+  void loadFloatCalibration() {
+    load();
+    uint32_t bits;
+    tempCalibration = deciFromFloatBits(EEPROM.get(EEPROM_TEMP_CAL_ADDR, bits));
+    humCalibration = deciFromFloatBits(EEPROM.get(EEPROM_HUM_CAL_ADDR, bits));
+    validateSettings();
+  }
+
+  // float IEEE 754 в десятые доли целочисленно: 1.mmm * 2^e * 10
+  // с округлением. Меньше 0,03 - ноль, NaN и больше 2^8 - вне диапазона
+  static Deci deciFromFloatBits(uint32_t bits) {
+    int16_t e = (int16_t)((bits >> 23) & 0xFF) - 127;
+    if (e < -5) return 0;
+    if (e > 7) return 0x7FFF;
+    uint32_t mant = (bits & 0x7FFFFFUL) | 0x800000UL;
+    uint8_t shift = 23 - e;
+    Deci v = (mant * 10 + (1UL << (shift - 1))) >> shift;
+    return (bits & 0x80000000UL) ? -v : v;
+  }
+
   // Валидация загруженных настроек
   void validateSettings() {
     // Проверка влажности
@@ -86,11 +112,11 @@ public:
       maxHumidity = DEFAULT_MAX_HUMIDITY;
     }
 
-    // Проверка калибровки (на NaN и диапазон)
-    if (isnan(tempCalibration) || tempCalibration < -10.0 || tempCalibration > 10.0) {
+    // Проверка калибровки
+    if (tempCalibration < DECI(-10) || tempCalibration > DECI(10)) {
       tempCalibration = TEMP_CALIBRATION;
     }
-    if (isnan(humCalibration) || humCalibration < -20.0 || humCalibration > 20.0) {
+    if (humCalibration < DECI(-20) || humCalibration > DECI(20)) {
       humCalibration = HUM_CALIBRATION;
     }
 
@@ -121,17 +147,18 @@ public:
     EEPROM.put(EEPROM_WATER_THRESHOLD_ADDR, waterThreshold);
 
     needsSave = false;
-    lastSaveTime = millis();
   }
 
-  // Проверка и сохранение (вызывать в loop)
+  // Отложенное сохранение. Вызывается планировщиком раз в
+  // EEPROM_SAVE_INTERVAL, поэтому запись идет не чаще раза в минуту
   void tick() {
-    // Сохраняем не чаще раза в минуту для защиты EEPROM
-    if (needsSave && (millis() - lastSaveTime >= 60000)) {
+    if (needsSave) {
       saveDirect();
     }
   }
 
+  bool isSavePending() const { return needsSave; }
+
   // Установка значений по умолчанию
   void setDefaults() {
     minHumidity = DEFAULT_MIN_HUMIDITY;
@@ -154,8 +181,8 @@ public:
   uint8_t getMinHumidity() const { return minHumidity; }
   uint8_t getMaxHumidity() const { return maxHumidity; }
   uint8_t getHysteresis() const { return hysteresis; }
-  float getTempCalibration() const { return tempCalibration; }
-  float getHumCalibration() const { return humCalibration; }
+  Deci getTempCalibration() const { return tempCalibration; }
+  Deci getHumCalibration() const { return humCalibration; }
   unsigned long getWorkTime() const { return workTime; }
   unsigned long getTotalSwitches() const { return totalSwitches; }
   uint16_t getWaterThreshold() const { return waterThreshold; }
@@ -185,17 +212,17 @@ public:
     }
   }
 
-  void setTempCalibration(float value) {
-    float newValue = constrain(value, -10.0, 10.0);
-    if (abs(newValue - tempCalibration) > 0.01) {
+  void setTempCalibration(Deci value) {
+    Deci newValue = constrain(value, DECI(-10), DECI(10));
+    if (newValue != tempCalibration) {
       tempCalibration = newValue;
       save();
     }
   }
 
-  void setHumCalibration(float value) {
-    float newValue = constrain(value, -20.0, 20.0);
-    if (abs(newValue - humCalibration) > 0.01) {
+  void setHumCalibration(Deci value) {
+    Deci newValue = constrain(value, DECI(-20), DECI(20));
+    if (newValue != humCalibration) {
       humCalibration = newValue;
       save();
     }
@@ -0,0 +1,38 @@
+# Прогон humidifier_sim и проверка итога: переключения в час не выше
+# лимита прошивки, доля времени в полосе уставок не ниже MIN_IN_BAND.
+#
+#   cmake -DSIM=humidifier_sim [-DMIN_IN_BAND=85] -P sim_check.cmake
+
+if(NOT SIM)
+  message(FATAL_ERROR "SIM is not set")
+endif()
+if(NOT MIN_IN_BAND)
+  set(MIN_IN_BAND 85)
+endif()
+
+execute_process(
+  COMMAND ${SIM} --hours 24 --noise 2
+  OUTPUT_VARIABLE out
+  RESULT_VARIABLE rc)
+message("${out}")
+if(NOT rc EQUAL 0)
+  message(FATAL_ERROR "humidifier_sim exited with ${rc}")
+endif()
+
+# switches_per_hour  0.50 (max 1, limit 10)
+if(NOT out MATCHES "switches_per_hour +[0-9.]+ \\(max ([0-9]+), limit ([0-9]+)\\)")
+  message(FATAL_ERROR "no switches_per_hour in the summary")
+endif()
+set(max_switches ${CMAKE_MATCH_1})
+set(limit ${CMAKE_MATCH_2})
+if(max_switches GREATER limit)
+  message(FATAL_ERROR "switches per hour ${max_switches} > limit ${limit}")
+endif()
+
+# time_in_band       91.3 %
+if(NOT out MATCHES "time_in_band +([0-9]+)\\.[0-9]+ %")
+  message(FATAL_ERROR "no time_in_band in the summary")
+endif()
+if(CMAKE_MATCH_1 LESS MIN_IN_BAND)
+  message(FATAL_ERROR "time in band ${CMAKE_MATCH_1} % < ${MIN_IN_BAND} %")
+endif()
@@ -0,0 +1,218 @@
+/*
+ * ОЧЕРЕДЬ ПЕРЕДАЧИ I2C (TWI) ПО ПРЕРЫВАНИЯМ
+ * Wire ждет, пока байты уйдут на шину, и полный кадр дисплея
+ * останавливает loop() на десятки мс. Здесь транзакции только
+ * складываются в кольцевой буфер, а отправляет их обработчик
+ * прерывания TWI, байт за байтом, пока loop() занят своим.
+ *
+ * Транзакция в буфере: [адрес][длина][данные...]. Обработчик видит
+ * только закрытые транзакции (до committed), поэтому открытая не
+ * уходит на шину недописанной. Если места нет, write() ждет, пока
+ * шина освободит буфер: транзакция длиннее TWI_QUEUE_SIZE - 3 байт
+ * не поместится никогда.
+ *
+ * Чтение (датчики на той же шине) - [адрес | TWI_READ][длина] без
+ * данных: принятые байты ISR пишет в буфер вызывающего, итог -
+ * getReadState(). Чтение в очереди одно, дальше ждут записи
+ * в порядке очереди, поэтому "регистр, затем чтение" идет подряд.
+ *
+ * На Nano Wire не подключается: его twi.c занимает тот же вектор
+ * TWI_vect. GyverOLED работает через microWire (опрос, без прерываний)
+ * и только при инициализации, до twi.begin()
+ */
+
+#ifndef TWI_H
+#define TWI_H
+
+#include "hal.h"
+#include "config.h"
+
+#define TWI_READ 0x80   // Бит чтения в байте адреса транзакции
+
+enum TwiReadState {
+  TWI_READ_IDLE = 0,
+  TWI_READ_PENDING = 1,   // В очереди или на шине
+  TWI_READ_DONE = 2,
+  TWI_READ_FAILED = 3     // NACK на адрес или ошибка шины
+};
+
+class TwiQueue {
+private:
+  uint8_t ring[TWI_QUEUE_SIZE];
+  volatile uint8_t readPos;     // Следующий байт для шины (ISR)
+  volatile uint8_t committed;   // Конец закрытых транзакций
+  uint8_t writePos;             // Конец открытой транзакции
+  uint8_t lenPos;               // Байт длины открытой транзакции
+  uint8_t openLen;
+
+  // Только ISR и kick() при запрещенных прерываниях
+  volatile bool active;         // Шина занята
+  volatile uint8_t remaining;   // Байт данных текущей транзакции
+  volatile uint8_t errors;      // Транзакций без ACK, с переполнением
+  volatile bool reading;        // Текущая транзакция - чтение
+  uint8_t* volatile readDest;   // Куда ISR пишет принятый байт
+  volatile uint8_t readState;
+
+  static TwiQueue*& instance() {
+    static TwiQueue* inst = nullptr;
+    return inst;
+  }
+
+  static uint8_t next(uint8_t i) {
+    return i + 1 >= TWI_QUEUE_SIZE ? 0 : i + 1;
+  }
+
+  // Байт в конец открытой транзакции, с ожиданием места
+  void put(uint8_t b) {
+    while (next(writePos) == readPos) halTwiWait();
+    ring[writePos] = b;
+    writePos = next(writePos);
+  }
+
+  // Запуск шины, если она стоит, а в очереди есть транзакции
+  void kick() {
+    noInterrupts();
+    if (!active && readPos != committed) {
+      active = true;
+      halTwiStart();
+    }
+    interrupts();
+  }
+
+  uint8_t take() {
+    uint8_t b = ring[readPos];
+    readPos = next(readPos);
+    return b;
+  }
+
+  void onInterrupt() {
+    switch (halTwiStatus()) {
+      case HAL_TWI_START:
+        {
+          uint8_t address = take();
+          remaining = take();
+          reading = address & TWI_READ;
+          halTwiWrite((address << 1) | (reading ? 1 : 0));
+        }
+        return;
+
+      case HAL_TWI_READ_ACK:
+        halTwiReceive(remaining > 1);
+        return;
+
+      case HAL_TWI_RX_ACK:
+      case HAL_TWI_RX_NACK:
+        {
+          uint8_t* dest = readDest;
+          *dest = halTwiData();
+          readDest = dest + 1;
+        }
+        if (--remaining) {
+          halTwiReceive(remaining > 1);
+          return;
+        }
+        readState = TWI_READ_DONE;
+        break;
+
+      case HAL_TWI_ADDR_ACK:
+      case HAL_TWI_DATA_ACK:
+        if (remaining) {
+          remaining--;
+          halTwiWrite(take());
+          return;
+        }
+        break;
+
+      default:
+        // NACK или ошибка шины: остаток транзакции пропускается
+        errors++;
+        if (reading) {
+          remaining = 0;
+          readState = TWI_READ_FAILED;
+        }
+        while (remaining) {
+          remaining--;
+          take();
+        }
+        break;
+    }
+
+    // Конец транзакции: следующая начинается сразу за STOP
+    bool more = readPos != committed;
+    halTwiStop(more);
+    active = more;
+  }
+
+public:
+  TwiQueue() : readPos(0), committed(0), writePos(0), lenPos(0), openLen(0),
+               active(false), remaining(0), errors(0), reading(false),
+               readDest(nullptr), readState(TWI_READ_IDLE) {}
+
+  void begin(unsigned long clock) {
+    instance() = this;
+    halTwiBegin(clock);
+  }
+
+  static void isr() {
+    if (instance()) instance()->onInterrupt();
+  }
+
+  void beginTransmission(uint8_t address) {
+    put(address & 0x7F);
+    lenPos = writePos;
+    put(0);
+    openLen = 0;
+  }
+
+  size_t write(uint8_t b) {
+    put(b);
+    openLen++;
+    return 1;
+  }
+
+  // Закрывает транзакцию и будит шину. Итог передачи придет позже,
+  // ошибки копятся в getErrors()
+  void endTransmission() {
+    ring[lenPos] = openLen;
+    committed = writePos;
+    kick();
+  }
+
+  // Чтение length байт в buffer (он должен жить до конца чтения).
+  // false - предыдущее чтение еще не завершено
+  bool requestFrom(uint8_t address, uint8_t* buffer, uint8_t length) {
+    if (readState == TWI_READ_PENDING || length == 0) return false;
+    readDest = buffer;
+    readState = TWI_READ_PENDING;
+    put((address & 0x7F) | TWI_READ);
+    put(length);
+    committed = writePos;
+    kick();
+    return true;
+  }
+
+  // Итог последнего requestFrom()
+  uint8_t getReadState() const { return readState; }
+
+  // Свободно байт в буфере
+  uint8_t space() const {
+    uint8_t used = writePos >= readPos ? writePos - readPos
+                                       : TWI_QUEUE_SIZE - readPos + writePos;
+    return TWI_QUEUE_SIZE - 1 - used;
+  }
+
+  bool isBusy() const { return active || readPos != committed; }
+
+  // Ждет, пока все закрытые транзакции уйдут на шину
+  void flush() {
+    while (isBusy()) halTwiWait();
+  }
+
+  uint8_t getErrors() const { return errors; }
+};
+
+HAL_ISR_TWI() {
+  TwiQueue::isr();
+}
+
+#endif // TWI_H